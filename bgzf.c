@@ -0,0 +1,507 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Reader for plain and bgzip-compressed files with support for tabix (.tbi) and CSI (.csi) indexes
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include "bgzf.h"
+#include "contig.h"
+#define merror "\nERROR: System out of memory\n"
+#define block_max 65536
+
+static int readBlock(Bgzf_s *fp);
+static int cmpBin(const void *a, const void *b);
+static Bin_s *findBin(Ref_s *ref, unsigned int bin);
+static int32_t readInt32(gzFile fp);
+static uint64_t readUint64(gzFile fp);
+static Index_s *readIndex(gzFile fp, int csi);
+
+Bgzf_s *bgzfOpen(const char *name){
+    
+    int c;
+    Bgzf_s *fp;
+    
+    if((fp = calloc(1, sizeof(Bgzf_s))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    if(strcmp(name, "-") == 0)
+        fp->fp = stdin;
+    else if((fp->fp = fopen(name, "r")) == NULL){
+        free(fp);
+        return NULL;
+    }
+    
+    c = getc(fp->fp);
+    if(c != EOF)
+        ungetc(c, fp->fp);
+    
+    if(c == 31){
+        fp->bgzf = 1;
+        if((fp->in = malloc(block_max)) == NULL || (fp->out = malloc(block_max)) == NULL){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+    return fp;
+}
+
+void bgzfClose(Bgzf_s *fp){
+    
+    fclose(fp->fp);
+    free(fp->in);
+    free(fp->out);
+    free(fp);
+}
+
+static int readBlock(Bgzf_s *fp){
+    
+    int bsize=-1;
+    size_t i, n, xlen, clen;
+    uLong isize;
+    unsigned char head[12];
+    z_stream zs;
+    
+    fp->block_address = fp->next_address;
+    fp->block_offset = 0;
+    fp->block_length = 0;
+    
+    if((n = fread(head, 1, 12, fp->fp)) == 0)
+        return 0;
+    
+    if(n != 12 || head[0] != 31 || head[1] != 139 || head[2] != 8 || (head[3] & 4) == 0){
+        fprintf(stderr,"\nERROR: File is not compressed with bgzip\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    xlen = head[10] | head[11] << 8;
+    
+    if(fread(fp->in, 1, xlen, fp->fp) != xlen){
+        fprintf(stderr,"\nERROR: Truncated bgzip block\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    for(i=0;i+4<=xlen;i+=4+(fp->in[i+2]|fp->in[i+3]<<8)){
+        if(fp->in[i] == 'B' && fp->in[i+1] == 'C' && (fp->in[i+2]|fp->in[i+3]<<8) == 2){
+            bsize = fp->in[i+4] | fp->in[i+5] << 8;
+            break;
+        }
+    }
+    
+    if(bsize < 0){
+        fprintf(stderr,"\nERROR: File is not compressed with bgzip\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    n = (size_t)bsize + 1 < 20 + xlen ? 0 : bsize + 1 - 12 - xlen;
+    
+    if(n < 8 || fread(fp->in, 1, n, fp->fp) != n){
+        fprintf(stderr,"\nERROR: Truncated bgzip block\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    clen = n - 8;
+    isize = fp->in[n-4] | fp->in[n-3] << 8 | fp->in[n-2] << 16 | (uLong)fp->in[n-1] << 24;
+    
+    memset(&zs, 0, sizeof(z_stream));
+    zs.next_in = fp->in;
+    zs.avail_in = clen;
+    zs.next_out = fp->out;
+    zs.avail_out = block_max;
+    
+    if(inflateInit2(&zs, -15) != Z_OK || inflate(&zs, Z_FINISH) != Z_STREAM_END || zs.total_out != isize){
+        fprintf(stderr,"\nERROR: Corrupted bgzip block at offset %lli\n\n", (long long)fp->block_address);
+        exit(EXIT_FAILURE);
+    }
+    
+    inflateEnd(&zs);
+    
+    fp->block_length = isize;
+    fp->next_address = fp->block_address + bsize + 1;
+    
+    return 1;
+}
+
+int bgzfGetc(Bgzf_s *fp){
+    
+    int c;
+    
+    if(fp->bgzf == 0)
+        return getc(fp->fp);
+    
+    if((c = bgzfPeek(fp)) == EOF)
+        return EOF;
+    
+    if(++fp->block_offset >= fp->block_length){
+        fp->block_address = fp->next_address;
+        fp->block_offset = 0;
+        fp->block_length = 0;
+    }
+    
+    return c;
+}
+
+int bgzfPeek(Bgzf_s *fp){
+    
+    int c;
+    
+    if(fp->bgzf == 0){
+        if((c = getc(fp->fp)) != EOF)
+            ungetc(c, fp->fp);
+        return c;
+    }
+    
+    while(fp->block_offset >= fp->block_length){
+        if(readBlock(fp) == 0)
+            return EOF;
+    }
+    
+    return fp->out[fp->block_offset];
+}
+
+ssize_t bgzfGetline(char **line, size_t *len, Bgzf_s *fp){
+    
+    int k;
+    size_t n=0;
+    unsigned char *p, *q;
+    
+    if(fp->bgzf == 0)
+        return getline(line, len, fp->fp);
+    
+    while(1){
+        if(fp->block_offset >= fp->block_length){
+            if(readBlock(fp) == 0)
+                break;
+            continue;
+        }
+        p = fp->out + fp->block_offset;
+        q = memchr(p, '\n', fp->block_length - fp->block_offset);
+        k = q != NULL ? q - p + 1 : fp->block_length - fp->block_offset;
+        if(*line == NULL || n + k + 1 > *len){
+            *len = (n + k + 1) * 2;
+            if((*line = realloc(*line, *len)) == NULL){
+                fprintf(stderr,merror);
+                exit(EXIT_FAILURE);
+            }
+        }
+        memcpy(*line + n, p, k);
+        n += k;
+        fp->block_offset += k;
+        if(q != NULL)
+            break;
+    }
+    
+    if(fp->block_offset >= fp->block_length){
+        fp->block_address = fp->next_address;
+        fp->block_offset = 0;
+        fp->block_length = 0;
+    }
+    
+    if(n == 0)
+        return -1;
+    
+    (*line)[n] = '\0';
+    
+    return n;
+}
+
+int64_t bgzfTell(Bgzf_s *fp){
+    
+    if(fp->bgzf == 0)
+        return ftello(fp->fp);
+    
+    return fp->block_address << 16 | fp->block_offset;
+}
+
+int bgzfSeek(Bgzf_s *fp, int64_t offset){
+    
+    if(fp->bgzf == 0)
+        return fseeko(fp->fp, offset, SEEK_SET);
+    
+    if(fseeko(fp->fp, offset >> 16, SEEK_SET) != 0)
+        return -1;
+    
+    fp->next_address = offset >> 16;
+    readBlock(fp);
+    fp->block_offset = offset & 0xFFFF;
+    
+    return 0;
+}
+
+static int32_t readInt32(gzFile fp){
+    
+    unsigned char b[4];
+    
+    if(gzread(fp, b, 4) != 4){
+        fprintf(stderr,"\nERROR: Truncated index file\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    return (int32_t)((uint32_t)b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16 | (uint32_t)b[3] << 24);
+}
+
+static uint64_t readUint64(gzFile fp){
+    
+    uint64_t lo, hi;
+    
+    lo = (uint32_t)readInt32(fp);
+    hi = (uint32_t)readInt32(fp);
+    
+    return lo | hi << 32;
+}
+
+Index_s *indexLoad(const char *name){
+    
+    int csi=0;
+    char *temp;
+    gzFile fp=NULL;
+    Index_s *idx;
+    
+    if((temp = malloc(strlen(name)+5)) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    sprintf(temp, "%s.tbi", name);
+    if((fp = gzopen(temp, "rb")) == NULL){
+        sprintf(temp, "%s.csi", name);
+        fp = gzopen(temp, "rb");
+        csi = 1;
+    }
+    
+    free(temp);
+    
+    if(fp == NULL)
+        return NULL;
+    
+    idx = readIndex(fp, csi);
+    gzclose(fp);
+    
+    return idx;
+}
+
+static Index_s *readIndex(gzFile fp, int csi){
+    
+    int i, j, k, l_aux=0, l_nm=0, name_i=0;
+    char magic[4], *names=NULL, *p;
+    Index_s *idx;
+    Ref_s *ref;
+    Bin_s *bin;
+    
+    if(gzread(fp, magic, 4) != 4 || memcmp(magic, csi ? "CSI\1" : "TBI\1", 4) != 0){
+        fprintf(stderr,"\nERROR: Unrecognised %s index\n\n", csi ? "CSI" : "tabix");
+        exit(EXIT_FAILURE);
+    }
+    
+    if((idx = calloc(1, sizeof(Index_s))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    idx->csi = csi;
+    idx->min_shift = 14;
+    idx->depth = 5;
+    
+    if(csi){
+        idx->min_shift = readInt32(fp);
+        idx->depth = readInt32(fp);
+        l_aux = readInt32(fp);
+        if(l_aux >= 28){
+            for(i=0;i<6;i++)
+                readInt32(fp);
+            l_nm = readInt32(fp);
+            l_aux -= 28;
+        }
+    }
+    
+    if(!csi){
+        idx->ref_n = readInt32(fp);
+        for(i=0;i<6;i++)
+            readInt32(fp);
+        l_nm = readInt32(fp);
+    }
+    
+    if(l_nm > 0){
+        if((names = malloc(l_nm)) == NULL){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+        if(gzread(fp, names, l_nm) != l_nm){
+            fprintf(stderr,"\nERROR: Truncated index file\n\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+    if(csi){
+        for(i=l_nm;i<l_aux;i++)
+            gzgetc(fp);
+        idx->ref_n = readInt32(fp);
+    }
+    
+    if((idx->refs = calloc(idx->ref_n, sizeof(Ref_s))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    for(i=0;i<idx->ref_n;i++){
+        ref = &idx->refs[i];
+        ref->chr = -1;
+        if(names != NULL && name_i < l_nm){
+            p = names + name_i;
+            if(p[0] != '\0')
+                ref->chr = contigId(p, strlen(p));
+            name_i += strlen(p) + 1;
+        }
+        ref->bin_n = readInt32(fp);
+        if((ref->bins = calloc(ref->bin_n, sizeof(Bin_s))) == NULL){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+        for(j=0;j<ref->bin_n;j++){
+            bin = &ref->bins[j];
+            bin->bin = (unsigned int)readInt32(fp);
+            if(csi)
+                bin->loffset = readUint64(fp);
+            bin->chunk_n = readInt32(fp);
+            if((bin->chunks = malloc(2*bin->chunk_n*sizeof(uint64_t))) == NULL){
+                fprintf(stderr,merror);
+                exit(EXIT_FAILURE);
+            }
+            for(k=0;k<2*bin->chunk_n;k++)
+                bin->chunks[k] = readUint64(fp);
+        }
+        qsort(ref->bins, ref->bin_n, sizeof(Bin_s), cmpBin);
+        if(!csi){
+            ref->intv_n = readInt32(fp);
+            if((ref->intv = malloc(ref->intv_n*sizeof(uint64_t))) == NULL){
+                fprintf(stderr,merror);
+                exit(EXIT_FAILURE);
+            }
+            for(j=0;j<ref->intv_n;j++)
+                ref->intv[j] = readUint64(fp);
+        }
+    }
+    
+    free(names);
+    
+    return idx;
+}
+
+int64_t indexQuery(Index_s *idx, int chr, int start, int stop){
+    
+    int i, l, t, s, lo, hi, mid;
+    int64_t beg, end, max, b, e;
+    uint64_t min_off=0, offset=UINT64_MAX;
+    Ref_s *ref=NULL;
+    Bin_s *bin;
+    
+    for(i=0;i<idx->ref_n;i++){
+        if(idx->refs[i].chr == chr){
+            ref = &idx->refs[i];
+            break;
+        }
+    }
+    
+    if(ref == NULL || ref->bin_n == 0)
+        return -1;
+    
+    max = (int64_t)1 << (idx->min_shift + 3*idx->depth);
+    beg = start > 0 ? start - 1 : 0;
+    end = stop < max ? stop : max;
+    
+    if(beg >= end)
+        return -1;
+    
+    if(idx->csi){
+        t = ((1 << 3*idx->depth) - 1) / 7;
+        for(b=t+(beg>>idx->min_shift);b>=0;b=(b-1)>>3){
+            if((bin = findBin(ref, b)) != NULL){
+                min_off = bin->loffset;
+                break;
+            }
+            if(b == 0)
+                break;
+        }
+    }
+    else if(ref->intv_n > 0)
+        min_off = ref->intv[(beg >> idx->min_shift) < ref->intv_n ? (beg >> idx->min_shift) : ref->intv_n - 1];
+    
+    for(l=0;l<=idx->depth;l++){
+        t = ((1 << 3*l) - 1) / 7;
+        s = idx->min_shift + 3*(idx->depth - l);
+        b = t + (beg >> s);
+        e = t + ((end - 1) >> s);
+        lo = 0;
+        hi = ref->bin_n;
+        while(lo < hi){
+            mid = (lo + hi) / 2;
+            if(ref->bins[mid].bin < b)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        for(i=lo;i<ref->bin_n&&ref->bins[i].bin<=e;i++){
+            bin = &ref->bins[i];
+            for(s=0;s<bin->chunk_n;s++){
+                if(bin->chunks[2*s+1] > min_off && bin->chunks[2*s] < offset)
+                    offset = bin->chunks[2*s];
+            }
+        }
+    }
+    
+    if(offset == UINT64_MAX)
+        return -1;
+    
+    return offset < min_off ? (int64_t)min_off : (int64_t)offset;
+}
+
+void indexFree(Index_s *idx){
+    
+    int i, j;
+    
+    for(i=0;i<idx->ref_n;i++){
+        for(j=0;j<idx->refs[i].bin_n;j++)
+            free(idx->refs[i].bins[j].chunks);
+        free(idx->refs[i].bins);
+        free(idx->refs[i].intv);
+    }
+    
+    free(idx->refs);
+    free(idx);
+}
+
+static int cmpBin(const void *a, const void *b){
+    
+    const Bin_s *x = a, *y = b;
+    
+    return (x->bin > y->bin) - (x->bin < y->bin);
+}
+
+static Bin_s *findBin(Ref_s *ref, unsigned int bin){
+    
+    Bin_s key;
+    
+    key.bin = bin;
+    
+    return bsearch(&key, ref->bins, ref->bin_n, sizeof(Bin_s), cmpBin);
+}
@@ -0,0 +1,65 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Reader for plain and bgzip-compressed files with support for tabix (.tbi) and CSI (.csi) indexes
+ 
+ Offsets returned by bgzfTell and indexQuery are byte offsets for plain files and virtual offsets (block address << 16 | offset within block) for bgzip-compressed files.
+ */
+
+#ifndef BGZF_H
+#define BGZF_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+typedef struct{
+    FILE *fp;
+    int bgzf, block_offset, block_length;
+    int64_t block_address, next_address;
+    unsigned char *in, *out;
+}Bgzf_s;
+
+typedef struct{
+    unsigned int bin;
+    int chunk_n;
+    uint64_t loffset, *chunks;
+}Bin_s;
+
+typedef struct{
+    int chr, bin_n, intv_n;
+    Bin_s *bins;
+    uint64_t *intv;
+}Ref_s;
+
+typedef struct{
+    int ref_n, min_shift, depth, csi;
+    Ref_s *refs;
+}Index_s;
+
+Bgzf_s *bgzfOpen(const char *name);
+void bgzfClose(Bgzf_s *fp);
+int bgzfGetc(Bgzf_s *fp);
+int bgzfPeek(Bgzf_s *fp);
+ssize_t bgzfGetline(char **line, size_t *len, Bgzf_s *fp);
+int64_t bgzfTell(Bgzf_s *fp);
+int bgzfSeek(Bgzf_s *fp, int64_t offset);
+Index_s *indexLoad(const char *name);
+int64_t indexQuery(Index_s *idx, int chr, int start, int stop);
+void indexFree(Index_s *idx);
+
+#endif
@@ -0,0 +1,231 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ Dictionary of chromosome names
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "contig.h"
+#define merror "\nERROR: System out of memory\n"
+
+static char **names;
+static int *table, name_n, name_max, table_size;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t hashName(const char *name, int len);
+static void growTable(void);
+
+int contigId(const char *name, int len){
+    
+    int i, id;
+    int64_t num=0;
+    uint64_t h;
+    
+    for(i=0;i<len && name[i] >= '0' && name[i] <= '9' && num < contig_base;i++)
+        num = num * 10 + name[i] - '0';
+    if(len > 0 && i == len && num < contig_base)
+        return num;
+    
+    pthread_mutex_lock(&lock);
+    
+    if(2 * (name_n + 1) > table_size)
+        growTable();
+    
+    for(h=hashName(name, len)&(table_size-1);table[h] >= 0;h=(h+1)&(table_size-1)){
+        if(strncmp(names[table[h]], name, len) == 0 && names[table[h]][len] == '\0')
+            break;
+    }
+    
+    if(table[h] < 0){
+        if(name_n == name_max){
+            name_max = name_max == 0 ? 256 : name_max * 2;
+            if((names = realloc(names, name_max*sizeof(char *))) == NULL){
+                fprintf(stderr,merror);
+                exit(EXIT_FAILURE);
+            }
+        }
+        if((names[name_n] = malloc(len+1)) == NULL){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+        memcpy(names[name_n], name, len);
+        names[name_n][len] = '\0';
+        table[h] = name_n++;
+    }
+    
+    id = contig_base + table[h];
+    
+    pthread_mutex_unlock(&lock);
+    
+    return id;
+}
+
+int contigLookup(Contig_s *last, const char *name, int len){
+    
+    if(last->len > 0 && len == last->len && memcmp(last->name, name, len) == 0)
+        return last->id;
+    
+    last->id = contigId(name, len);
+    last->len = len < contig_max ? len : 0;
+    memcpy(last->name, name, last->len);
+    
+    return last->id;
+}
+
+int contigField(Contig_s *last, const char *p, const char *eol){
+    
+    const char *end;
+    
+    for(end=p;end<eol && *end != '\t' && *end != ' ' && *end != '\n' && *end != '\r';end++);
+    
+    if(end == p)
+        return -1;
+    
+    return last != NULL ? contigLookup(last, p, end - p) : contigId(p, end - p);
+}
+
+int contigHeader(const char *line){
+    
+    const char *p, *end;
+    
+    if(strncmp(line, "##contig=<", 10) != 0 || (p = strstr(line, "ID=")) == NULL)
+        return -1;
+    
+    p += 3;
+    for(end=p;*end != '\0' && *end != ',' && *end != '>';end++);
+    
+    return end > p ? contigId(p, end - p) : -1;
+}
+
+int contigCount(void){
+    
+    int n;
+    
+    pthread_mutex_lock(&lock);
+    n = name_n;
+    pthread_mutex_unlock(&lock);
+    
+    return n;
+}
+
+const char *contigName(int chr, char *buf){
+    
+    const char *name=buf;
+    
+    if(chr < contig_base){
+        sprintf(buf, "%i", chr);
+        return buf;
+    }
+    
+    pthread_mutex_lock(&lock);
+    if(chr - contig_base < name_n)
+        name = names[chr-contig_base];
+    else
+        sprintf(buf, "?");
+    pthread_mutex_unlock(&lock);
+    
+    return name;
+}
+
+int *contigMap(const char *block, size_t size, int *n){
+    
+    int k, *map=NULL, same=1;
+    size_t i, len;
+    
+    for(i=0,*n=0;i<size;i+=len+1,(*n)++){
+        len = strnlen(block + i, size - i);
+        if((map = realloc(map, (*n+1)*sizeof(int))) == NULL){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+        map[*n] = contigId(block + i, len);
+        if(map[*n] != contig_base + *n)
+            same = 0;
+    }
+    
+    if(same == 1){
+        free(map);
+        return NULL;
+    }
+    
+    for(k=0;k<*n;k++){
+        if(map[k] < contig_base){
+            fprintf(stderr,"\nERROR: The cache names a numbered chromosome\n\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+    return map;
+}
+
+void contigBlock(void **block, size_t *size){
+    
+    int i, n=contigCount();
+    size_t len;
+    char buf[contig_buf];
+    const char *name;
+    
+    *block = NULL;
+    *size = 0;
+    
+    for(i=0;i<n;i++){
+        name = contigName(contig_base + i, buf);
+        len = strlen(name) + 1;
+        if((*block = realloc(*block, *size + len)) == NULL){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+        memcpy((char *)*block + *size, name, len);
+        *size += len;
+    }
+}
+
+static uint64_t hashName(const char *name, int len){
+    
+    int i;
+    uint64_t h=0xcbf29ce484222325ULL;
+    
+    for(i=0;i<len;i++)
+        h = (h ^ (unsigned char)name[i]) * 0x100000001b3ULL;
+    
+    return h ^ (h >> 32);
+}
+
+static void growTable(void){
+    
+    int i;
+    uint64_t h;
+    
+    table_size = table_size == 0 ? 1024 : table_size * 2;
+    
+    free(table);
+    if((table = malloc(table_size*sizeof(int))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    for(i=0;i<table_size;i++)
+        table[i] = -1;
+    
+    for(i=0;i<name_n;i++){
+        for(h=hashName(names[i], strlen(names[i]))&(table_size-1);table[h] >= 0;h=(h+1)&(table_size-1));
+        table[h] = i;
+    }
+}
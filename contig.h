@@ -0,0 +1,46 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ Dictionary of chromosome names
+ 
+ contigId turns the name of a chromosome into the number stored in the keys. Names of digits only keep their value, so 1 sorts before 10 as before, and any other name (chr1, scaffold_12, ChrM) is interned to contig_base plus the order in which it was first seen. The dictionary is shared by all files and threads of a program, so the ##contig lines of the vcf-file (read by sourceOpen) or the names stored in its index or cache give the contigs the order of the vcf-file when it is opened before the other files. contigLookup keeps the last name of a reader in a Contig_s and compares against it first, so the lock around the hash table is only taken when the chromosome changes. contigField does the same for the field at p of a text file (last can be NULL), and returns -1 for an empty field.
+ 
+ contigName writes a number back as the name (buf is needed for the numbers), and contigCount and contigHeader help to store and read the names of the caches and headers. contigBlock packs the names in the order of their ids, each ending in a zero byte, and contigMap interns such a block again and returns the new id of each name, or NULL when they all keep their ids.
+ */
+
+#ifndef CONTIG_H
+#define CONTIG_H
+
+#include <stddef.h>
+#define contig_base 1073741824
+#define contig_buf 16
+#define contig_max 64
+
+typedef struct{
+    int id, len;
+    char name[contig_max];
+}Contig_s;
+
+int contigId(const char *name, int len);
+int contigLookup(Contig_s *last, const char *name, int len);
+int contigField(Contig_s *last, const char *p, const char *eol);
+int contigHeader(const char *line);
+int contigCount(void);
+const char *contigName(int chr, char *buf);
+int *contigMap(const char *block, size_t size, int *n);
+void contigBlock(void **block, size_t *size);
+
+#endif
@@ -0,0 +1,693 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Derived allele frequencies of genes and windows, the core of estDAF
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "daf.h"
+#include "vcf.h"
+#include "merge.h"
+#include "gtcache.h"
+#define merror "\nERROR: System out of memory\n"
+
+typedef struct{
+    Reader_s in;
+    int ploidy, parsers;
+    Keys_s *mismatch;
+    Region_s *genes;
+    Keys_s *gene_keys, *coords, *div_keys;
+    Site_s *div;
+    Dense_s *dense;
+    Pops_s *pops;
+    int use, grp_n, row_n, row_max, gene_hi, coord_hi, *gene_row, *hits, *site_rows;
+    Gene_s *rows;
+    int win_size, win_step, win_chr, win_head, win_n, win_max, win_i, win_names, *win_rec, *win_site;
+    int64_t win_next;
+    Gene_s *win_sum;
+    Region_s *wins;
+}Job_s;
+
+static void runJob(void *arg);
+static void scanVcf(Job_s *job);
+static void parseChunk(void *arg, Chunk_s *chunk);
+static void mergeChunk(void *arg, Chunk_s *chunk);
+static void scanCache(Job_s *job);
+static void scanTally(Job_s *job);
+static void countGenotypes(Job_s *job, int g, unsigned char *a1, unsigned char *a2, int n, int *m, int *n00, int *n11, int *nmiss);
+static void cacheGenotypes(Job_s *job, int g, Row_s *row, int *m, int *n00, int *n11, int *nmiss);
+static int matchGenes(Job_s *job, uint64_t key, uint64_t *next);
+static int matchCoords(Job_s *job, uint64_t key, uint64_t *next);
+static int matchDiv(Job_s *job, uint64_t key, int *div_i, Site_s *site);
+static int geneRow(Job_s *job, int gene_i);
+static void addCounts(Job_s *job, int row_n, int mask, int rd, int g, int n, int n00, int n11, int nmiss);
+static Gene_s *addGene(Job_s *job, int gene_i);
+static void windowAdd(Job_s *job, uint64_t key, int mask);
+static void windowMove(Job_s *job, int64_t pos);
+static void windowSite(Job_s *job, int *rec, int sign);
+static Region_s *seekRegions(Region_s *genes, int gene_n, int *n);
+
+Daf_s *dafScan(Source_s *src, Pops_s *pops, Region_s *genes, Keys_s *gene_keys, Keys_s *coords, Keys_s *div_keys, Site_s *div, Dense_s *dense, int use, int threads, int parsers, int ploidy, int win_size, int win_step, Stats_s *stats){
+    
+    int i, j, k, g, r, job_n, reg_n=0, row_n=0, grp_n=pops != NULL ? pops->n : 1;
+    Region_s *regions=NULL, *names, *prev_names=NULL;
+    Keys_s *empty=NULL;
+    Job_s *jobs, *prev=NULL;
+    Gene_s *row;
+    Daf_s *daf;
+    
+    sourcePops(src, pops, ploidy);
+    
+    if(gene_keys == NULL){
+        gene_keys = empty = keysInit(0, 0);
+        keysIndex(empty);
+    }
+    
+    if(src->idx != NULL)
+        regions = seekRegions(genes, gene_keys->n, &reg_n);
+    
+    job_n = sourceSplit(src, &threads, 1);
+    
+    if((jobs = calloc(job_n, sizeof(Job_s))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    for(i=0;i<job_n;i++){
+        sourceReader(src, &jobs[i].in, i, regions, reg_n);
+        jobs[i].genes = genes;
+        jobs[i].gene_keys = gene_keys;
+        jobs[i].coords = coords;
+        jobs[i].div_keys = div_keys;
+        jobs[i].div = div;
+        jobs[i].dense = dense;
+        jobs[i].pops = pops;
+        jobs[i].grp_n = grp_n;
+        jobs[i].use = use;
+        jobs[i].mismatch = keysInit(1, 0);
+        jobs[i].ploidy = ploidy;
+        jobs[i].parsers = parsers;
+        jobs[i].win_size = win_size;
+        jobs[i].win_step = win_step;
+        if(win_size > 0 && ((jobs[i].win_sum = calloc(grp_n, sizeof(Gene_s))) == NULL || (jobs[i].win_site = malloc(2*grp_n*sizeof(int))) == NULL)){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+        if((jobs[i].gene_row = malloc((gene_keys->n+1)*sizeof(int))) == NULL || (jobs[i].hits = malloc((gene_keys->n+1)*sizeof(int))) == NULL || (jobs[i].site_rows = malloc((gene_keys->n+1)*sizeof(int))) == NULL){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+        for(j=0;j<gene_keys->n;j++)
+            jobs[i].gene_row[j] = -1;
+    }
+    
+    runPool(jobs, sizeof(Job_s), job_n, threads, runJob);
+    
+    for(i=0;i<job_n;i++){
+        if(jobs[i].row_n == 0)
+            continue;
+        names = win_size > 0 ? jobs[i].wins : genes;
+        if(prev != NULL && strcmp(prev_names[prev->rows[prev->row_n-grp_n].gene].id, names[jobs[i].rows[0].gene].id) == 0){
+            for(g=0;g<grp_n;g++){
+                row = &prev->rows[prev->row_n-grp_n+g];
+                for(k=0;k<gc_n;k++){
+                    jobs[i].rows[g].da_i[k] += row->da_i[k];
+                    jobs[i].rows[g].a_i[k] += row->a_i[k];
+                    jobs[i].rows[g].s_i[k] += row->s_i[k];
+                }
+            }
+            prev->row_n -= grp_n;
+        }
+        prev = &jobs[i];
+        prev_names = names;
+    }
+    
+    for(i=0;i<job_n;i++){
+        statsAdd(&stats->count, &jobs[i].in.count);
+        statsMismatch(stats, jobs[i].mismatch);
+        keysFree(jobs[i].mismatch);
+        row_n += jobs[i].row_n;
+    }
+    
+    if((daf = calloc(1, sizeof(Daf_s))) == NULL || (daf->rows = malloc((row_n+1)*sizeof(Gene_s))) == NULL || (daf->names = malloc((row_n/grp_n+1)*sizeof(Region_s))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    daf->pops = pops;
+    daf->grp_n = grp_n;
+    daf->win_size = win_size;
+    
+    for(i=0;i<job_n;i++){
+        names = win_size > 0 ? jobs[i].wins : genes;
+        for(j=0;j<jobs[i].row_n;j+=grp_n){
+            r = daf->row_n / grp_n;
+            daf->names[r] = names[jobs[i].rows[j].gene];
+            for(g=0;g<grp_n;g++){
+                daf->rows[daf->row_n] = jobs[i].rows[j+g];
+                daf->rows[daf->row_n++].gene = r;
+            }
+        }
+        free(jobs[i].rows);
+        free(jobs[i].gene_row);
+        free(jobs[i].hits);
+        free(jobs[i].site_rows);
+        free(jobs[i].win_rec);
+        free(jobs[i].win_site);
+        free(jobs[i].win_sum);
+        free(jobs[i].wins);
+        readerClose(src, &jobs[i].in);
+    }
+    
+    if(empty != NULL)
+        keysFree(empty);
+    free(regions);
+    free(jobs);
+    
+    return daf;
+}
+
+void dafWrite(Daf_s *daf, Writer_s **out){
+    
+    int j, k, g;
+    double freq=0;
+    Gene_s *row;
+    
+    for(j=0;j<daf->row_n;j+=daf->grp_n){
+        row = &daf->rows[j];
+        for(k=0;k<gc_n;k++){
+            if(out[k] == NULL)
+                continue;
+            if(j == 0 && daf->pops == NULL)
+                writeStr(out[k], daf->win_size > 0 ? "chr\tstart\tend\tDAF\tnSites\n" : "gene\tDAF\tnSites\n");
+            else if(j == 0){
+                writeStr(out[k], daf->win_size > 0 ? "chr\tstart\tend" : "gene");
+                for(g=0;g<daf->grp_n;g++){
+                    writeStr(out[k], "\tDAF_");
+                    writeStr(out[k], daf->pops->groups[g].id);
+                }
+                writeStr(out[k], "\tnSites\n");
+            }
+            writeStr(out[k], daf->names[row->gene].id);
+            for(g=0;g<daf->grp_n;g++){
+                freq = (double)row[g].da_i[k]/(double)row[g].a_i[k];
+                writeChar(out[k], '\t');
+                writeFloat(out[k], freq);
+            }
+            writeChar(out[k], '\t');
+            writeInt(out[k], row->s_i[k]);
+            writeChar(out[k], '\n');
+        }
+    }
+}
+
+void dafFree(Daf_s *daf){
+    
+    free(daf->rows);
+    free(daf->names);
+    free(daf);
+}
+
+static void runJob(void *arg){
+    
+    Job_s *job = arg;
+    
+    if(job->in.tally != NULL)
+        scanTally(job);
+    else if(job->in.cache != NULL)
+        scanCache(job);
+    else
+        scanVcf(job);
+}
+
+static void scanVcf(Job_s *job){
+    
+    runPipe(&job->in, job->parsers, job, parseChunk, mergeChunk);
+    
+    if(job->win_size > 0)
+        windowMove(job, INT64_MAX);
+}
+
+static void parseChunk(void *arg, Chunk_s *chunk){
+    
+    int g, k, m, *rec, chr=0, pos=0, first=1, div_i=0, gene_hi=0, coord_hi=0, rd=0, mask=0, n=0, n00=0, n11=0, nmiss=0;
+    char ref, alt, *line, *end, *next, *field[10];
+    uint64_t key;
+    Job_s *job = arg;
+    Keys_s *gene_keys=job->gene_keys, *coords=job->coords;
+    Site_s site;
+    
+    for(line=chunk->text;line<chunk->text+chunk->len;line=next+1){
+        end = next = memchr(line, '\n', chunk->text + chunk->len - line);
+        while(end > line && (end[-1] == '\n' || end[-1] == '\r'))
+            end--;
+        *end = '\0';
+        if(line[0] == '#' || (k = vcfFields(line, end, field, 10)) < 5)
+            continue;
+        chunk->count.lines++;
+        chr = contigLookup(&chunk->contig, line, field[1] - line - 1);
+        pos = atoi(field[1]);
+        key = makeKey(chr, pos);
+        chunkOrder(chunk, key);
+        if(first == 1){
+            div_i = job->dense == NULL ? keySearch(job->div_keys, key) : 0;
+            gene_hi = keySearchUpper(gene_keys, key);
+            coord_hi = job->dense == NULL ? keySearchUpper(coords, key) : 0;
+            first = 0;
+        }
+        if(job->win_size == 0){
+            gene_hi = keyUpper(gene_keys, gene_hi, key);
+            if(keyOverlaps(gene_keys, gene_hi, key, NULL) == 0)
+                continue;
+        }
+        if(job->dense != NULL ? denseAligned(job->dense, key) == 0 : keyOverlaps(coords, coord_hi = keyUpper(coords, coord_hi, key), key, NULL) == 0)
+            continue;
+        rd = matchDiv(job, key, &div_i, &site);
+        ref = field[3][0];
+        alt = field[4][0];
+        mask = 0;
+        if(rd == 1 && ref != site.ref){
+            chunk->count.mismatch++;
+            mask = -1;
+        }
+        else if(rd == 0 || alt == site.alt){
+            if((mask = (classMask(gc_strict, ref, alt, rd) | 1) & job->use) == 0)
+                chunk->count.gc_skip++;
+        }
+        if(mask == 0 && job->win_size > 0)
+            continue;
+        rec = chunkRecord(chunk, mask > 0 ? 4 + 4 * job->grp_n : 4);
+        rec[0] = mask;
+        rec[1] = rd;
+        rec[2] = chr;
+        rec[3] = pos;
+        if(mask <= 0)
+            continue;
+        chunk->count.kept++;
+        if(k >= 10 && job->ploidy > 0)
+            ploidyCheck(job->in.header, field[9], end, job->ploidy, key);
+        n = k < 10 ? 0 : job->ploidy >= 2 ? vcfDosage(field[9], end, job->ploidy, &chunk->a1, &chunk->a2, &chunk->gt_max) : vcfGenotypes(field[9], end, &chunk->a1, &chunk->a2, &chunk->gt_max);
+        for(g=0;g<job->grp_n;g++){
+            countGenotypes(job, g, chunk->a1, chunk->a2, n, &m, &n00, &n11, &nmiss);
+            rec[4+4*g] = m;
+            rec[5+4*g] = n00;
+            rec[6+4*g] = n11;
+            rec[7+4*g] = nmiss;
+        }
+    }
+}
+
+static void mergeChunk(void *arg, Chunk_s *chunk){
+    
+    int g, *rec, row_n=0;
+    size_t i;
+    uint64_t key, next;
+    Job_s *job = arg;
+    
+    for(i=0;i<chunk->rec_n;i+=rec[0] > 0 ? 4 + 4 * job->grp_n : 4){
+        rec = chunk->recs + i;
+        key = makeKey(rec[2], rec[3]);
+        if(job->win_size == 0)
+            row_n = matchGenes(job, key, &next);
+        if(rec[0] < 0)
+            keysAdd(job->mismatch, rec[2], rec[3], rec[3]);
+        if(rec[0] <= 0)
+            continue;
+        for(g=0;g<job->grp_n;g++)
+            addCounts(job, row_n, rec[0], rec[1], g, rec[4+4*g], rec[5+4*g], rec[6+4*g], rec[7+4*g]);
+        if(job->win_size > 0)
+            windowAdd(job, key, rec[0]);
+    }
+}
+
+static void scanCache(Job_s *job){
+    
+    int g, m, div_i=0, rd=0, mask=0, n00=0, n11=0, nmiss=0, row_n=0;
+    int64_t i;
+    char ref, alt;
+    uint64_t next;
+    Site_s out;
+    Cache_s *cache=job->in.cache;
+    Row_s *site;
+    
+    for(i=job->in.first;i<job->in.last;i++){
+        site = cacheRow(cache, i);
+        job->in.count.lines++;
+        job->in.count.bytes += cache->stride;
+        if(job->win_size > 0 ? matchCoords(job, site->key, &next) == 0 : (row_n = matchGenes(job, site->key, &next)) == 0){
+            if(next == UINT64_MAX)
+                break;
+            i = cacheFind(cache, i, job->in.last, next) - 1;
+            continue;
+        }
+        rd = matchDiv(job, site->key, &div_i, &out);
+        ref = site->ref;
+        if(rd == 1 && ref != out.ref){
+            job->in.count.mismatch++;
+            keysAdd(job->mismatch, keyChr(site->key), keyPos(site->key), keyPos(site->key));
+            continue;
+        }
+        alt = site->alt;
+        if(rd == 1 && alt != out.alt)
+            continue;
+        mask = (classMask(gc_strict, ref, alt, rd) | 1) & job->use;
+        if(mask == 0){
+            job->in.count.gc_skip++;
+            continue;
+        }
+        job->in.count.kept++;
+        for(g=0;g<job->grp_n;g++){
+            cacheGenotypes(job, g, site, &m, &n00, &n11, &nmiss);
+            addCounts(job, row_n, mask, rd, g, m, n00, n11, nmiss);
+        }
+        if(job->win_size > 0)
+            windowAdd(job, site->key, mask);
+    }
+    
+    if(job->win_size > 0)
+        windowMove(job, INT64_MAX);
+}
+
+static void scanTally(Job_s *job){
+    
+    int g, i, div_i=0, rd=0, mask=0, row_n=0, *rec;
+    char ref, alt;
+    uint64_t key, next;
+    Site_s out;
+    Tally_s *tally=job->in.tally;
+    
+    for(i=job->in.first;i<job->in.last;i++){
+        key = tally->keys->start[i];
+        rec = tallyRec(tally, i);
+        job->in.count.lines++;
+        job->in.count.bytes += tally->stride*sizeof(int);
+        if(job->win_size > 0 ? matchCoords(job, key, &next) == 0 : (row_n = matchGenes(job, key, &next)) == 0){
+            if(next == UINT64_MAX)
+                break;
+            i = tallyFind(tally, i, job->in.last, next) - 1;
+            continue;
+        }
+        rd = matchDiv(job, key, &div_i, &out);
+        ref = rec[0] & 255;
+        if(rd == 1 && ref != out.ref){
+            job->in.count.mismatch++;
+            keysAdd(job->mismatch, keyChr(key), keyPos(key), keyPos(key));
+            continue;
+        }
+        alt = rec[0] >> 8;
+        if(rd == 1 && alt != out.alt)
+            continue;
+        mask = (classMask(gc_strict, ref, alt, rd) | 1) & job->use;
+        if(mask == 0){
+            job->in.count.gc_skip++;
+            continue;
+        }
+        job->in.count.kept++;
+        for(g=0;g<job->grp_n;g++)
+            addCounts(job, row_n, mask, rd, g, rec[1+4*g], rec[2+4*g], rec[3+4*g], rec[4+4*g]);
+        if(job->win_size > 0)
+            windowAdd(job, key, mask);
+    }
+    
+    if(job->win_size > 0)
+        windowMove(job, INT64_MAX);
+}
+
+static void countGenotypes(Job_s *job, int g, unsigned char *a1, unsigned char *a2, int n, int *m, int *n00, int *n11, int *nmiss){
+    
+    if(job->ploidy >= 2){
+        if(job->pops == NULL)
+            vcfDoseCount(a1, a2, n, job->ploidy, m, n00, n11, nmiss);
+        else
+            popsDoseCount(&job->pops->groups[g], a1, a2, n, job->ploidy, m, n00, n11, nmiss);
+        return;
+    }
+    
+    if(job->pops == NULL){
+        vcfCount(a1, a2, n, n00, n11, nmiss);
+        *m = n;
+    }
+    else
+        popsCount(&job->pops->groups[g], a1, a2, n, m, n00, n11, nmiss);
+}
+
+static void cacheGenotypes(Job_s *job, int g, Row_s *row, int *m, int *n00, int *n11, int *nmiss){
+    
+    if(job->pops == NULL){
+        cacheCount(job->in.cache, row, n00, n11, nmiss);
+        *m = row->n;
+    }
+    else
+        cacheCountMask(job->in.cache, row, job->pops->groups[g].mask, m, n00, n11, nmiss);
+    
+    if(job->ploidy == 2)
+        vcfAlleles(m, n00, n11, nmiss);
+}
+
+static int matchGenes(Job_s *job, uint64_t key, uint64_t *next){
+    
+    int i, j, r, hit_n, n=0;
+    Keys_s *gene_keys=job->gene_keys;
+    
+    job->gene_hi = keyUpper(gene_keys, job->gene_hi, key);
+    if((hit_n = keyOverlaps(gene_keys, job->gene_hi, key, job->hits)) == 0){
+        *next = job->gene_hi < gene_keys->n ? gene_keys->start[job->gene_hi] : UINT64_MAX;
+        return 0;
+    }
+    
+    if(matchCoords(job, key, next) == 0)
+        return 0;
+    
+    for(i=hit_n-1;i>=0;i--){
+        r = geneRow(job, job->hits[i]);
+        for(j=0;j<n && job->site_rows[j] != r;j++);
+        if(j == n)
+            job->site_rows[n++] = r;
+    }
+    
+    return n;
+}
+
+static int matchCoords(Job_s *job, uint64_t key, uint64_t *next){
+    
+    Keys_s *coords=job->coords;
+    
+    if(job->dense != NULL){
+        *next = key + 1;
+        return denseAligned(job->dense, key);
+    }
+    
+    job->coord_hi = keyUpper(coords, job->coord_hi, key);
+    if(keyOverlaps(coords, job->coord_hi, key, NULL) == 0){
+        *next = job->coord_hi < coords->n ? coords->start[job->coord_hi] : UINT64_MAX;
+        return 0;
+    }
+    
+    return 1;
+}
+
+static int matchDiv(Job_s *job, uint64_t key, int *div_i, Site_s *site){
+    
+    if(job->dense != NULL)
+        return denseDiv(job->dense, key, &site->ref, &site->alt);
+    
+    *div_i = keySeek(job->div_keys, *div_i, key);
+    if(keyHit(job->div_keys, *div_i, key) == 0)
+        return 0;
+    *site = job->div[*div_i];
+    
+    return 1;
+}
+
+static int geneRow(Job_s *job, int gene_i){
+    
+    if(job->gene_row[gene_i] < 0){
+        if(job->row_n == 0 || strcmp(job->genes[job->rows[job->row_n-job->grp_n].gene].id, job->genes[gene_i].id) != 0)
+            addGene(job, gene_i);
+        job->gene_row[gene_i] = job->row_n - job->grp_n;
+    }
+    
+    return job->gene_row[gene_i];
+}
+
+static void addCounts(Job_s *job, int row_n, int mask, int rd, int g, int n, int n00, int n11, int nmiss){
+    
+    int i, k;
+    Gene_s *row;
+    
+    if(job->win_size > 0){
+        job->win_site[2*g] = rd == 1 ? n00 : n11;
+        job->win_site[2*g+1] = n - nmiss;
+    }
+    
+    for(i=0;i<row_n;i++){
+        row = &job->rows[job->site_rows[i]+g];
+        for(k=0;k<gc_n;k++){
+            if(mask & (1 << k)){
+                row->da_i[k] += rd == 1 ? n00 : n11;
+                row->a_i[k] += n - nmiss;
+                row->s_i[k]++;
+            }
+        }
+    }
+}
+
+static Gene_s *addGene(Job_s *job, int gene_i){
+    
+    int g;
+    
+    if(job->row_n + job->grp_n > job->row_max){
+        job->row_max = job->row_max == 0 ? 1024 * job->grp_n : job->row_max * 2;
+        if((job->rows = realloc(job->rows, job->row_max*sizeof(Gene_s))) == NULL){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+    memset(&job->rows[job->row_n], 0, job->grp_n*sizeof(Gene_s));
+    for(g=0;g<job->grp_n;g++)
+        job->rows[job->row_n+g].gene = gene_i;
+    job->row_n += job->grp_n;
+    
+    return &job->rows[job->row_n-job->grp_n];
+}
+
+static void windowAdd(Job_s *job, uint64_t key, int mask){
+    
+    int g, chr=keyChr(key), pos=keyPos(key), size=job->win_size, step=job->win_step, stride=2+2*job->grp_n, *rec;
+    int64_t first;
+    
+    if(chr != job->win_chr){
+        windowMove(job, INT64_MAX);
+        job->win_chr = chr;
+        job->win_next = 0;
+    }
+    else
+        windowMove(job, pos);
+    
+    if(job->win_n == 0){
+        first = pos > size ? (pos - size + step - 1) / step : 0;
+        if(first > job->win_next)
+            job->win_next = first;
+    }
+    
+    if(job->win_head + job->win_n == job->win_max){
+        if(job->win_head > 0){
+            memmove(job->win_rec, job->win_rec + (size_t)job->win_head*stride, (size_t)job->win_n*stride*sizeof(int));
+            job->win_head = 0;
+        }
+        else{
+            job->win_max = job->win_max == 0 ? 1024 : job->win_max * 2;
+            if((job->win_rec = realloc(job->win_rec, (size_t)job->win_max*stride*sizeof(int))) == NULL){
+                fprintf(stderr,merror);
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    
+    rec = job->win_rec + (size_t)(job->win_head+job->win_n)*stride;
+    rec[0] = pos;
+    rec[1] = mask;
+    for(g=0;g<2*job->grp_n;g++)
+        rec[2+g] = job->win_site[g];
+    job->win_n++;
+    
+    windowSite(job, rec, 1);
+}
+
+static void windowMove(Job_s *job, int64_t pos){
+    
+    int g, stride=2+2*job->grp_n, *rec;
+    int64_t start;
+    char buf[contig_buf];
+    Gene_s *row;
+    Region_s *win;
+    
+    while(job->win_n > 0 && job->win_next*job->win_step + job->win_size < pos){
+        start = job->win_next*job->win_step + 1;
+        while(job->win_n > 0 && (rec = job->win_rec + (size_t)job->win_head*stride)[0] < start){
+            windowSite(job, rec, -1);
+            job->win_head++;
+            job->win_n--;
+        }
+        if(job->win_n > 0){
+            if(job->win_i == job->win_names){
+                job->win_names = job->win_names == 0 ? 1024 : job->win_names * 2;
+                if((job->wins = realloc(job->wins, job->win_names*sizeof(Region_s))) == NULL){
+                    fprintf(stderr,merror);
+                    exit(EXIT_FAILURE);
+                }
+            }
+            win = &job->wins[job->win_i];
+            win->chr = job->win_chr;
+            win->start = start;
+            win->stop = start + job->win_size - 1;
+            snprintf(win->id, sizeof(win->id), "%s\t%i\t%i", contigName(win->chr, buf), win->start, win->stop);
+            row = addGene(job, job->win_i++);
+            for(g=0;g<job->grp_n;g++){
+                row[g] = job->win_sum[g];
+                row[g].gene = job->win_i - 1;
+            }
+        }
+        job->win_next++;
+    }
+    
+    if(job->win_n == 0)
+        job->win_head = 0;
+}
+
+static void windowSite(Job_s *job, int *rec, int sign){
+    
+    int g, k;
+    
+    for(g=0;g<job->grp_n;g++){
+        for(k=0;k<gc_n;k++){
+            if(rec[1] & (1 << k)){
+                job->win_sum[g].da_i[k] += sign * rec[2+2*g];
+                job->win_sum[g].a_i[k] += sign * rec[3+2*g];
+                job->win_sum[g].s_i[k] += sign;
+            }
+        }
+    }
+}
+
+static Region_s *seekRegions(Region_s *genes, int gene_n, int *n){
+    
+    int i;
+    Region_s *list;
+    
+    if((list = malloc((gene_n+1)*sizeof(Region_s))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    for(i=0;i<gene_n;i++){
+        if(*n > 0 && genes[i].chr == list[*n-1].chr && genes[i].start <= list[*n-1].stop + seek_gap){
+            if(genes[i].stop > list[*n-1].stop)
+                list[*n-1].stop = genes[i].stop;
+        }
+        else{
+            list[*n] = genes[i];
+            *n = *n + 1;
+        }
+    }
+    
+    return list;
+}
+
@@ -0,0 +1,48 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Derived allele frequencies of genes and windows, the core of estDAF
+ 
+ dafScan reads a Source_s once and counts the derived and called alleles of every gene (or window of win_size bp when genes is NULL) for each DAF-class set in use (bit k for class k of gcclass.h) and each group of pops. The genes, coordinates, substitutions and pops are only read, so they can be loaded once and used for any number of scans. The result holds one row per gene and group, named after the gene or "chr\tstart\tend" for windows, and is written with dafWrite as one table per class (out[k] NULL for the classes not written). With dense (see denseInit) the coordinates and substitutions are looked up in its bitmaps instead, and coords, div_keys and div can be NULL. pops must be kept until the result is written. threads chromosomes are scanned in parallel and parsers threads parse the lines of each of them (see runPipe).
+ */
+
+#ifndef DAF_H
+#define DAF_H
+
+#include "gcclass.h"
+#include "mummer.h"
+#include "pops.h"
+#include "scan.h"
+#include "stats.h"
+#include "writer.h"
+
+typedef struct{
+    int gene, da_i[gc_n], a_i[gc_n], s_i[gc_n];
+}Gene_s;
+
+typedef struct{
+    Gene_s *rows;
+    Region_s *names;
+    Pops_s *pops;
+    int row_n, grp_n, win_size;
+}Daf_s;
+
+Daf_s *dafScan(Source_s *src, Pops_s *pops, Region_s *genes, Keys_s *gene_keys, Keys_s *coords, Keys_s *div_keys, Site_s *div, Dense_s *dense, int use, int threads, int parsers, int ploidy, int win_size, int win_step, Stats_s *stats);
+void dafWrite(Daf_s *daf, Writer_s **out);
+void dafFree(Daf_s *daf);
+
+#endif
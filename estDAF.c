@@ -17,45 +17,55 @@
  
  Program for estimating derived allele frequencies
  
- compiling: gcc estDAF.c -o estDAF -lm
+ compiling: gcc -O2 estDAF.c daf.c scan.c bgzf.c vcf.c input.c merge.c gtcache.c pops.c mummer.c contig.c tally.c stats.c writer.c -o estDAF -lm -lpthread -lz (add -march=native to scan genotypes with AVX2)
+ 
+ or against the shared library: gcc -O2 estDAF.c -o estDAF -L. -lgcbias (see gcbias.h)
  
  usage:
- -coord [file] coordinates file produced by 'show-coords' program from MUMmer (use settings -H -T)
- -div [file] substitution file produced by 'show-snps' program from MUMmer (use settings -C -I -H -T)
- -vcf [file] vcf-file with variant sites
- -genes [file] tab-delimited file with name, chromosome, start, and end for each gene
- -gc [int] different DAF-classes 1 [WS] 2 [SW] 3 [SS] 4 [WW] 5 [SS+WW]
+ -coord [file] coordinates file produced by 'show-coords' program from MUMmer (use settings -H -T), or a coordinate cache made with makeCache
+ -div [file] substitution file produced by 'show-snps' program from MUMmer (use settings -C -I -H -T), or a substitution cache made with makeCache
+ -vcf [file] vcf-file with variant sites, plain or compressed with bgzip (a .tbi or .csi index is used to read only the genes), or a genotype cache made with makeCache
+ -genes [file] tab-delimited file with name, chromosome, start, and end for each gene (genes may overlap or nest, and each gets every site it contains)
+ -window [int] writes the DAF of sliding windows of this length along each chromosome instead of genes, each line starting with chromosome, start and end (replaces -genes)
+ -step [int] distance between the starts of consecutive windows (default the window length)
+ -ploidy [int] counts alleles instead of homozygous individuals, for calls with this many sets of chromosomes (2 for diploids with heterozygous calls and more for polyploids, which need a vcf-file instead of a genotype cache; only the 0 and 1 alleles of a call are counted, and the program stops at a call of the vcf-file with another number of alleles, optional)
+ -pops [file] tab-delimited file with sample name and group for each sample to use, writes one DAF column for each group (optional)
+ -gc [int] different DAF-classes 1 [WS] 2 [SW] 3 [SS] 4 [WW] 5 [SS+WW], or 'all' for every class in a single pass
+ -out [prefix] prefix for the output files when using -gc all (prefix.all.txt, prefix.WS.txt, prefix.SW.txt, prefix.SS.txt, prefix.WW.txt, prefix.SSWW.txt)
+ -gz compresses the output with gzip (adds .gz to the -out file names, optional)
+ -mismatch [file] writes the chromosome and position of every site where the reference base of the vcf-file and the substitution file differ (optional, a summary for each chromosome is always printed)
+ -stats [file] writes the time spent in each phase and counts of the lines and sites read as tab-delimited name and value (optional)
+ -threads [int] number of chromosomes processed in parallel (requires a regular or indexed vcf-file or a genotype cache, default 1)
+ -parse-threads [int] number of threads parsing the lines of each chromosome, next to one thread reading and one counting them (vcf-file only, default 0)
+ -dense keeps the coordinates and substitutions as a bitmap of each chromosome instead of sorted lists, for constant-time lookups and less memory with many substitutions (needs A, C, G and T bases, optional)
+ -save-counts [file] saves the genotype counts of each group at every aligned site of the vcf-file, added to those of -add-counts (optional)
+ -add-counts [file] counts saved with -save-counts by an earlier run, to which the samples of -vcf are added, or which are used instead of a vcf-file when -vcf is not given (optional)
  
  example:
  ./estDAF -coord thaliana-lyrata.filt.coord -div thaliana-lyrata.filt.snps -vcf thaliana.poly.vcf -genes thaliana.genes.txt -gc 1 > out.WS.txt
+ ./estDAF -coord thaliana-lyrata.filt.coord -div thaliana-lyrata.filt.snps -vcf thaliana.poly.vcf -genes thaliana.genes.txt -gc all -out out
+ ./estDAF -coord thaliana-lyrata.filt.coord -div thaliana-lyrata.filt.snps -vcf thaliana.poly.vcf -genes thaliana.genes.txt -pops thaliana.pops.txt -gc 1 > out.WS.pops.txt
+ ./estDAF -coord thaliana-lyrata.filt.coord -div thaliana-lyrata.filt.snps -vcf thaliana.poly.vcf -window 100000 -step 10000 -gc 1 > out.WS.windows.txt
+ ./estDAF -coord thaliana-lyrata.filt.coord -div thaliana-lyrata.filt.snps -vcf thaliana.batch2.vcf -add-counts panel.counts -save-counts panel.counts -genes thaliana.genes.txt -gc 1 > out.WS.txt
+ 
+ Windows are counted in one pass: each site is added when the scan reaches it and removed when the window start passes it, so the work grows with the number of sites and not with the number of windows. Only windows with at least one site are written, and the last windows of a chromosome may extend past its end.
+ 
+ With -save-counts and -add-counts, a panel that grows in batches of samples is counted incrementally: each run reads only the vcf-file of the new samples (with a -pops file naming the same groups in the same order, whose samples missing from the vcf-file are taken to be in other batches) and adds its counts to the saved ones, site by site. The classes, substitutions, genes and windows are applied to the counts in each run, so they can change between runs, and the results are the same as from one vcf-file with all samples, except at sites missing from some of the batches, which count as not called in their samples. The same -ploidy has to be used in every run, and the file can be both read and saved in one run.
+ 
+ One input file can be given as '-' to read it from standard input, and inputs can also be named pipes (e.g. bcftools view ... | ./estDAF -vcf - ...). Index seeking, -threads and the caches made with makeCache need a regular file.
  
- The program was written for A.thaliana data. It assumes that all files are sorted by chromosome and position, chromosomes are identified with numbers (e.g. 1 and not chr1), and VCF-file contains no heterozygote sites.
+ The program was written for A.thaliana data. The coordinate, substitution, gene, region and site files are sorted in memory when they are out of order, but the vcf-file has to be sorted by chromosome and position (the program stops if it is not). Chromosomes can be numbers or names (1, chr1 or scaffold_12), and numbered chromosomes come before named ones, which follow the ##contig lines of the vcf-file, its index or cache, or the order of a regular vcf-file (from a pipe without ##contig lines, the order in which the other files first name them). VCF-file contains no heterozygote sites (unless -ploidy is given).
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
 #include <unistd.h>
 #include <time.h>
+#include "gcbias.h"
 #define merror "\nERROR: System out of memory\n"
 
-typedef struct{
-    int chr, start, stop;
-    char id[50];
-}Region_s;
-
-typedef struct{
-    int chr, pos;
-    char ref, alt;
-}Site_s;
-
 void openFiles(int argc, char *argv[]);
-Region_s *readCoord(FILE *coord_file, int *n);
-Region_s *readGenes(FILE *gene_file, int *n);
-Site_s *readDiv(FILE *div_file, int *n);
-void readVcf(FILE *vcf_file, Region_s *genes, Region_s *coords, Site_s *div, int gc, int gene_n, int coord_n, int div_n);
-void lineTerminator(char *line);
 
 int main(int argc, char *argv[]){
     
@@ -89,17 +99,40 @@ int main(int argc, char *argv[]){
 
 void openFiles(int argc, char *argv[]){
     
-    int i, gc=0, coord_n=0, div_n=0, site_n=0, vcf_n, gene_n=0;
-    FILE *vcf_file=NULL, *coord_file=NULL, *div_file=NULL, *gene_file=NULL;
-    Region_s *coords, *genes;
+    int i, gc=0, std_n=0, threads=1, gz=0, win_size=0, win_step=0, ploidy=0, use=0, parsers=0, dense_on=0;
+    char *prefix=NULL, *name=NULL, *vcf_name=NULL, *save_name=NULL;
+    FILE *coord_file=NULL, *div_file=NULL, *gene_file=NULL, *pop_file=NULL, *add_file=NULL, *save_file, *out_file[gc_n]={NULL};
+    Pops_s *pops=NULL;
+    Region_s *genes;
+    Keys_s *gene_keys, *coords, *div_keys;
     Site_s *div;
+    Dense_s *dense=NULL;
+    Bgzf_s *vcf_file=NULL;
+    FILE *stats_file=NULL, *mis_file=NULL;
+    Stats_s stats;
+    Writer_s *out[gc_n]={NULL};
+    Tally_s *tally=NULL, *batch;
+    Source_s *src=NULL;
+    Daf_s *daf;
+    
+    statsInit(&stats);
+    
+    for(i=1;i<argc;i++){
+        if(strcmp(argv[i], "-") == 0)
+            std_n++;
+    }
+    
+    if(std_n > 1){
+        fprintf(stderr,"\nERROR: Only one input can be read from standard input\n\n");
+        exit(EXIT_FAILURE);
+    }
     
     fprintf(stderr,"\nParameters:\n");
     
     for(i=1;i<argc;i++){
         
         if(strcmp(argv[i], "-coord") == 0){
-            if((coord_file = fopen(argv[++i], "r")) == NULL){
+            if((coord_file = openInput(argv[++i])) == NULL){
                 fprintf(stderr,"\nERROR: Cannot open file %s\n\n", argv[i]);
                 exit(EXIT_FAILURE);
             }
@@ -107,7 +140,7 @@ void openFiles(int argc, char *argv[]){
         }
         
         else if(strcmp(argv[i], "-div") == 0){
-            if((div_file = fopen(argv[++i], "r")) == NULL){
+            if((div_file = openInput(argv[++i])) == NULL){
                 fprintf(stderr,"\nERROR: Cannot open file %s\n\n", argv[i]);
                 exit(EXIT_FAILURE);
             }
@@ -115,30 +148,132 @@ void openFiles(int argc, char *argv[]){
         }
         
         else if(strcmp(argv[i], "-vcf") == 0){
-            if((vcf_file = fopen(argv[++i], "r")) == NULL){
+            if((vcf_file = bgzfOpen(argv[++i])) == NULL){
                 fprintf(stderr,"\nERROR: Cannot open file %s\n\n", argv[i]);
                 exit(EXIT_FAILURE);
             }
+            vcf_name = argv[i];
             fprintf(stderr,"\t-vcf %s\n", argv[i]);
         }
         
         else if(strcmp(argv[i], "-genes") == 0){
-            if((gene_file = fopen(argv[++i], "r")) == NULL){
+            if((gene_file = openInput(argv[++i])) == NULL){
                 fprintf(stderr,"\nERROR: Cannot open file %s\n\n", argv[i]);
                 exit(EXIT_FAILURE);
             }
             fprintf(stderr,"\t-genes %s\n", argv[i]);
         }
         
-        else if(strcmp(argv[i], "-gc") == 0){
-            gc = atoi(argv[++i]);
-            if(gc < 0 || gc > 5){
-                fprintf(stderr,"\nERROR: allowed values for -gc are 1 [WS], 2 [SW] 3 [SS] 4 [WW] 5 [SS+WW]\n\n", argv[i]);
+        else if(strcmp(argv[i], "-window") == 0){
+            win_size = atoi(argv[++i]);
+            if(win_size < 1){
+                fprintf(stderr,"\nERROR: -window must be at least 1\n\n");
                 exit(EXIT_FAILURE);
             }
+            fprintf(stderr,"\t-window %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-step") == 0){
+            win_step = atoi(argv[++i]);
+            if(win_step < 1){
+                fprintf(stderr,"\nERROR: -step must be at least 1\n\n");
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr,"\t-step %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-ploidy") == 0){
+            ploidy = atoi(argv[++i]);
+            if(ploidy < 2 || ploidy > 254){
+                fprintf(stderr,"\nERROR: -ploidy must be between 2 and 254\n\n");
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr,"\t-ploidy %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-pops") == 0){
+            if((pop_file = openInput(argv[++i])) == NULL){
+                fprintf(stderr,"\nERROR: Cannot open file %s\n\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr,"\t-pops %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-gc") == 0){
+            if(strcmp(argv[++i], "all") == 0)
+                gc = -1;
+            else{
+                gc = atoi(argv[i]);
+                if(gc < 0 || gc > 5){
+                    fprintf(stderr,"\nERROR: allowed values for -gc are 1 [WS], 2 [SW] 3 [SS] 4 [WW] 5 [SS+WW] or all\n\n");
+                    exit(EXIT_FAILURE);
+                }
+            }
             fprintf(stderr,"\t-gc %s\n", argv[i]);
         }
         
+        else if(strcmp(argv[i], "-out") == 0){
+            prefix = argv[++i];
+            fprintf(stderr,"\t-out %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-gz") == 0){
+            gz = 1;
+            fprintf(stderr,"\t-gz\n");
+        }
+        
+        else if(strcmp(argv[i], "-dense") == 0){
+            dense_on = 1;
+            fprintf(stderr,"\t-dense\n");
+        }
+        
+        else if(strcmp(argv[i], "-mismatch") == 0){
+            if((mis_file = fopen(argv[++i], "w")) == NULL){
+                fprintf(stderr,"\nERROR: Cannot open file %s\n\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr,"\t-mismatch %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-stats") == 0){
+            if((stats_file = fopen(argv[++i], "w")) == NULL){
+                fprintf(stderr,"\nERROR: Cannot open file %s\n\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr,"\t-stats %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-threads") == 0){
+            threads = atoi(argv[++i]);
+            if(threads < 1){
+                fprintf(stderr,"\nERROR: -threads must be at least 1\n\n");
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr,"\t-threads %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-save-counts") == 0){
+            save_name = argv[++i];
+            fprintf(stderr,"\t-save-counts %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-add-counts") == 0){
+            if((add_file = openInput(argv[++i])) == NULL){
+                fprintf(stderr,"\nERROR: Cannot open file %s\n\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr,"\t-add-counts %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-parse-threads") == 0){
+            parsers = atoi(argv[++i]);
+            if(parsers < 0){
+                fprintf(stderr,"\nERROR: -parse-threads must be at least 0\n\n");
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr,"\t-parse-threads %s\n", argv[i]);
+        }
+        
         else{
             fprintf(stderr,"\nERROR: Unknown argument '%s'\n\n", argv[i]);
             exit(EXIT_FAILURE);
@@ -147,275 +282,147 @@ void openFiles(int argc, char *argv[]){
     
     fprintf(stderr,"\n");
     
-    if(gene_file == NULL || coord_file == NULL || div_file == NULL || vcf_file == NULL){
-        fprintf(stderr,"ERROR: The following parameters are required: -coord [file] -div [file] -vcf [file] -genes [file]\n\n");
+    if((gene_file == NULL && win_size == 0) || coord_file == NULL || div_file == NULL || (vcf_file == NULL && add_file == NULL)){
+        fprintf(stderr,"ERROR: The following parameters are required: -coord [file] -div [file] -vcf [file] (or -add-counts [file]) -genes [file] (or -window [int])\n\n");
         exit(EXIT_FAILURE);
     }
     
-    genes = readGenes(gene_file, &gene_n);
-    coords = readCoord(coord_file, &coord_n);
-    div = readDiv(div_file, &div_n);
-    readVcf(vcf_file, genes, coords, div, gc, gene_n, coord_n, div_n);
-}
-
-Region_s *readGenes(FILE *gene_file, int *n){
-    
-    int i, char_i=0, line_i=0, maxchar=0, coord_i=0;
-    char c, *line=NULL;
-    Region_s *list;
-    size_t len=0;
-    ssize_t read;
-    
-    while((c=fgetc(gene_file)) != EOF){
-        if(c == '\n')
-            line_i++;
-    }
-    
-    rewind(gene_file);
-    
-    if((list = malloc(line_i*sizeof(Region_s))) == NULL){
-        fprintf(stderr,merror);
+    if(gene_file != NULL && win_size > 0){
+        fprintf(stderr,"ERROR: -window cannot be combined with -genes\n\n");
         exit(EXIT_FAILURE);
     }
     
-    while((read = getline(&line, &len, gene_file)) != -1){
-        lineTerminator(line);
-        strncpy(list[*n].id, strtok(line,"\t"),49);
-        list[*n].chr = atoi(strtok(NULL,"\t"));
-        list[*n].start = atoi(strtok(NULL,"\t"));
-        list[*n].stop = atoi(strtok(NULL,"\t"));
-        *n = *n + 1;
+    if(win_step > 0 && win_size == 0){
+        fprintf(stderr,"ERROR: -step requires -window [int]\n\n");
+        exit(EXIT_FAILURE);
     }
     
-    free(line);
-    fclose(gene_file);
+    if(win_step == 0)
+        win_step = win_size;
     
-    return list;
-}
-
-Region_s *readCoord(FILE *coord_file, int *n){
-    
-    int i, char_i=0, line_i=0, maxchar=0;
-    char c, *line=NULL, *temp=NULL;
-    Region_s *list;
-    size_t len=0;
-    ssize_t read;
-    
-    while((c=fgetc(coord_file)) != EOF){
-        if(c == '\n')
-            line_i++;
+    if(gc == -1){
+        if(prefix == NULL){
+            fprintf(stderr,"ERROR: -gc all requires -out [prefix]\n\n");
+            exit(EXIT_FAILURE);
+        }
+        if((name = malloc(strlen(prefix)+13)) == NULL){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+        for(i=0;i<gc_n;i++){
+            sprintf(name, "%s.%s.txt%s", prefix, gc_names[i], gz ? ".gz" : "");
+            if((out_file[i] = fopen(name, "w")) == NULL){
+                fprintf(stderr,"ERROR: Cannot open file %s\n\n", name);
+                exit(EXIT_FAILURE);
+            }
+        }
+        free(name);
     }
+    else
+        out_file[gc] = stdout;
     
-    rewind(coord_file);
-    
-    if((list = malloc((line_i)*sizeof(Region_s))) == NULL){
-        fprintf(stderr,merror);
-        exit(EXIT_FAILURE);
+    for(i=0;i<gc_n;i++){
+        if(out_file[i] != NULL)
+            out[i] = writerOpen(out_file[i], gz);
     }
     
-    while((read = getline(&line, &len, coord_file)) != -1){
-        lineTerminator(line);
-        list[*n].start = atoi(strtok(line,"\t"));
-        list[*n].stop = atoi(strtok(NULL,"\t"));
-        for(i=0;i<6;i++)
-            temp = strtok(NULL,"\t");
-        if(isdigit(temp[0])){
-            list[*n].chr = atoi(temp);
-            *n = *n + 1;
+    if(vcf_file != NULL)
+        src = sourceOpen(vcf_file, vcf_name);
+    statsPhase(&stats, "setup");
+    gene_keys = NULL;
+    genes = NULL;
+    if(gene_file != NULL){
+        gene_keys = keysInit(0, 0);
+        genes = readGenes(gene_file, gene_keys);
+        keysIndex(gene_keys);
+        statsPhase(&stats, "genes");
+    }
+    coords = readCoord(coord_file);
+    keysIndex(coords);
+    statsPhase(&stats, "coord");
+    div_keys = keysInit(1, 0);
+    div = readDiv(div_file, NULL, div_keys);
+    statsPhase(&stats, "div");
+    if(pop_file != NULL){
+        pops = readPops(pop_file);
+        statsPhase(&stats, "pops");
+    }
+    if(add_file != NULL || save_name != NULL){
+        if(add_file != NULL)
+            tally = tallyRead(add_file);
+        if(src != NULL){
+            batch = sourceTally(src, pops, coords, ploidy, threads, parsers, &stats);
+            sourceClose(src);
+            if(tally == NULL)
+                tally = batch;
+            else{
+                tallyMerge(tally, batch);
+                tallyFree(batch);
+            }
         }
+        if(save_name != NULL){
+            if((save_file = fopen(save_name, "w")) == NULL){
+                fprintf(stderr,"\nERROR: Cannot open file %s\n\n", save_name);
+                exit(EXIT_FAILURE);
+            }
+            tallyWrite(tally, save_file);
+            fclose(save_file);
+        }
+        src = sourceCounts(tally);
+        statsPhase(&stats, "counts");
     }
-    
-    free(line);
-    fclose(coord_file);
-    
-    return list;
-}
-
-Site_s *readDiv(FILE *div_file, int *n){
-    
-    int i, j, char_i=0, line_i=0, maxchar=0;
-    char c, *line=NULL, *temp=NULL;
-    Site_s *list;
-    size_t len=0;
-    ssize_t read;
-    
-    while((c=fgetc(div_file)) != EOF){
-        if(c == '\n')
-            line_i++;
+    if(dense_on == 1){
+        dense = denseInit(coords, div_keys, div);
+        keysFree(coords);
+        keysFree(div_keys);
+        free(div);
+        coords = div_keys = NULL;
+        div = NULL;
+        statsPhase(&stats, "dense");
     }
     
-    rewind(div_file);
+    for(i=0;i<gc_n;i++){
+        if(out[i] != NULL)
+            use |= 1 << i;
+    }
     
-    if((list = malloc(line_i*sizeof(Site_s))) == NULL){
-        fprintf(stderr,merror);
-        exit(EXIT_FAILURE);
+    daf = dafScan(src, pops, genes, gene_keys, coords, div_keys, div, dense, use, threads, parsers, ploidy, win_size, win_step, &stats);
+    statsPhase(&stats, "vcf");
+    dafWrite(daf, out);
+    dafFree(daf);
+    sourceClose(src);
+    if(tally != NULL)
+        tallyFree(tally);
+    
+    if(gene_keys != NULL){
+        keysFree(gene_keys);
+        free(genes);
     }
-        
-    while((read = getline(&line, &len, div_file)) != -1){
-        lineTerminator(line);
-        list[*n].pos = atoi(strtok(line,"\t"));
-        temp = strtok(NULL,"\t");
-        list[*n].ref = temp[0];
-        temp = strtok(NULL,"\t");
-        list[*n].alt = temp[0];
-        for(i=0;i<6;i++)
-            temp = strtok(NULL,"\t");
-        if(isdigit(temp[0])){
-            list[*n].chr = atoi(temp);
-            *n = *n + 1;
-        }
+    if(dense != NULL)
+        denseFree(dense);
+    else{
+        keysFree(coords);
+        keysFree(div_keys);
+        free(div);
     }
-
-    free(line);
-    fclose(div_file);
     
-    return list;
-}
-
-void readVcf(FILE *vcf_file, Region_s *genes, Region_s *coords, Site_s *div, int gc, int gene_n, int coord_n, int div_n){
+    if(pops != NULL)
+        popsFree(pops);
     
-    int i, chr=0, pos=0, gene_i=0, coord_i=0, div_i=0, ok=0, rd=0, da_i=0, a_i=0, s_i=0;
-    double daf=0;
-    char ref, alt, *line=NULL, *temp=NULL, *gene=NULL;
-    size_t len=0;
-    ssize_t read;
-    
-    while((read = getline(&line, &len, vcf_file)) != -1){
-        lineTerminator(line);
-        temp = strtok(line,"\t");
-        if(isdigit(temp[0])){
-            chr = atoi(temp);
-            i = 1;
-            while(temp != NULL){
-                if(i == 2){
-                    pos =  atoi(temp);
-                    ok = 0;
-                    rd = 0;
-                    while(gene_i < gene_n){
-                        if(chr == genes[gene_i].chr){
-                            if(pos <= genes[gene_i].stop && pos >= genes[gene_i].start){
-                                while(coord_i < coord_n){
-                                    if(chr == coords[coord_i].chr){
-                                        if(pos <= coords[coord_i].stop && pos >= coords[coord_i].start){
-                                            if(gene == NULL){
-                                                gene = genes[gene_i].id;
-                                                printf("gene\tDAF\tnSites\n");
-                                            }
-                                            else if(strcmp(gene, genes[gene_i].id) != 0){
-                                                daf = (double)da_i/(double)a_i;
-                                                printf("%s\t%f\t%i\n", gene, daf, s_i);
-                                                da_i = 0;
-                                                a_i = 0;
-                                                s_i = 0;
-                                                gene = genes[gene_i].id;
-                                            }
-                                            while(div_i < div_n){
-                                                if(chr == div[div_i].chr){
-                                                    if(pos == div[div_i].pos){
-                                                        rd = 1;
-                                                        break;
-                                                    }
-                                                    else if(pos < div[div_i].pos)
-                                                        break;
-                                                }
-                                                else if(chr < div[div_i].chr)
-                                                    break;
-                                                div_i++;
-                                            }
-                                            ok = 1;
-                                            break;
-                                        }
-                                        else if(pos < coords[coord_i].start)
-                                            break;
-                                    }
-                                    else if(chr < coords[coord_i].chr)
-                                        break;
-                                    coord_i++;
-                                }
-                                break;
-                            }
-                            else if(pos < genes[gene_i].start)
-                                break;
-                        }
-                        else if(chr < genes[gene_i].chr)
-                            break;
-                        gene_i++;
-                    }
-                    if(ok == 0)
-                        break;
-                }
-                else if(i == 4){
-                    ref = temp[0];
-                    if(rd == 1 && ref != div[div_i].ref){
-                        fprintf(stderr,"Warning: ref alleles differ at chr %i pos %i\n", chr, pos);
-                        break;
-                    }
-                }
-                else if(i == 5){
-                    alt = temp[0];
-                    if(rd == 1 && alt != div[div_i].alt)
-                        break;
-                    if(gc != 0){
-                        ok = 0;
-                        if(gc == 3){
-                            if((ref == 'G' && alt == 'C') || (ref == 'C' && alt == 'G'))
-                                ok = 1;
-                        }
-                        else if(gc == 4){
-                            if((ref == 'A' && alt == 'T') || (ref == 'T' && alt == 'A'))
-                                ok = 1;
-                        }
-                        else if(gc == 5){
-                            if((ref == 'G' && alt == 'C') || (ref == 'C' && alt == 'G'))
-                                ok = 1;
-                            else if((ref == 'A' && alt == 'T') || (ref == 'T' && alt == 'A'))
-                                ok = 1;
-                        }
-                        else if(rd == 0){
-                            if(gc == 1 && (ref == 'A' || ref == 'T') && (alt == 'G' || alt == 'C'))
-                                ok = 1;
-                            else if(gc == 2 && (ref == 'G' || ref == 'C') && (alt == 'A' || alt == 'T'))
-                                ok = 1;
-                        }
-                        else{
-                            if(gc == 1 && (ref == 'G' || ref == 'C') && (alt == 'A' || alt == 'T'))
-                                ok = 1;
-                            else if(gc == 2 && (ref == 'A' || ref == 'T') && (alt == 'G' || alt == 'C'))
-                                ok = 1;
-                        }
-                        if(ok == 0)
-                            break;
-                    }
-                }
-                else if(i > 9){
-                    if(rd == 1 && (temp[0] == '0' && temp[2] == '0'))
-                        da_i++;
-                    else if(rd == 0 && (temp[0] == '1' && temp[2] == '1'))
-                        da_i++;
-                    if(temp[0] != '.' && temp[2] != '.')
-                        a_i++;
-                }
-                temp = strtok(NULL,"\t");
-                i++;
-                if(temp == NULL)
-                    s_i++;
-            }
-        }
+    for(i=0;i<gc_n;i++){
+        if(out[i] != NULL)
+            writerClose(out[i]);
+        if(out_file[i] != NULL && out_file[i] != stdout)
+            fclose(out_file[i]);
     }
     
-    free(line);
-    free(coords);
-    free(genes);
-    free(div);
-    fclose(vcf_file);
-}
-
-void lineTerminator(char *line){
-    
-    int i;
+    statsWarn(&stats, mis_file);
+    if(mis_file != NULL)
+        fclose(mis_file);
     
-    for(i=0;line[i]!=0;i++){
-        if(line[i] == '\n' || line[i] == '\r')
-            line[i] = '\0';
+    if(stats_file != NULL){
+        statsPhase(&stats, "output");
+        statsWrite(&stats, stats_file);
+        fclose(stats_file);
     }
 }
@@ -0,0 +1,57 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Interface of libgcbias, the code shared by estDAF and makeDFE-alpha
+ 
+ compiling: gcc -O2 -fPIC -shared daf.c sfs.c scan.c bgzf.c vcf.c input.c merge.c gtcache.c pops.c mummer.c contig.c tally.c stats.c writer.c -o libgcbias.so -lm -lpthread -lz (add -march=native to scan genotypes with AVX2)
+ 
+ The inputs are loaded once with readCoord, readDiv, readGenes, readTarget, readSites and readPops, and a vcf-file or genotype cache is opened with sourceOpen (first, so that its chromosome names keep their order, see contig.h). Each of dafScan and sfsScan then reads the source once for the given genes, windows, classes and groups, and returns a result that is written with dafWrite or sfsWrite. The loaded inputs are not changed by a scan, so a long-running program can keep them and run any number of scans. sourceTally and sourceCounts keep the genotype counts of a scan, to be saved and added to (see tally.h). Errors are written to stderr and end the program, as in the command line tools.
+ 
+ example:
+ src = sourceOpen(bgzfOpen("thaliana.poly.vcf.gz"), "thaliana.poly.vcf.gz");
+ coords = readCoord(fopen("thaliana-lyrata.filt.coord", "r"));
+ keysIndex(coords);
+ div_keys = keysInit(1, 0);
+ div = readDiv(fopen("thaliana-lyrata.filt.snps", "r"), NULL, div_keys);
+ statsInit(&stats);
+ daf = dafScan(src, NULL, NULL, NULL, coords, div_keys, div, NULL, 1 << 1, 8, 0, 0, 100000, 10000, &stats);
+ out = writerOpen(stdout, 0);
+ dafWrite(daf, (Writer_s *[gc_n]){NULL, out});
+ writerClose(out);
+ dafFree(daf);
+ */
+
+#ifndef GCBIAS_H
+#define GCBIAS_H
+
+#include "bgzf.h"
+#include "contig.h"
+#include "vcf.h"
+#include "input.h"
+#include "merge.h"
+#include "gtcache.h"
+#include "tally.h"
+#include "gcclass.h"
+#include "pops.h"
+#include "mummer.h"
+#include "stats.h"
+#include "writer.h"
+#include "scan.h"
+#include "daf.h"
+#include "sfs.h"
+
+#endif
@@ -0,0 +1,75 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Lookup tables for the GC-classes of a site
+ 
+ classMask maps (ref, alt, diverged) to a bit mask over gc_names (defined in scan.c): bit 1 WS, 2 SW, 3 SS, 4 WW and 5 SS+WW (bit 0 is left to the caller). Bases are first reduced to A, C, G, T, '.' or other with gc_base, so a lookup is two byte loads and no branches. gc_strict only classifies A, C, G and T and needs a real G<->C or A<->T change for SS and WW; gc_dot is used for the sites file, where '.' stands for either base and SS and WW include monomorphic sites.
+ */
+
+#ifndef GCCLASS_H
+#define GCCLASS_H
+
+#define gc_n 6
+
+extern const char *const gc_names[gc_n];
+
+static const unsigned char gc_base[256] = {['A'] = 1, ['C'] = 2, ['G'] = 3, ['T'] = 4, ['.'] = 5};
+
+static const unsigned char gc_strict[2][6][6] = {
+    {
+        {0,  0,  0,  0,  0,  0},
+        {0,  0,  2,  2, 48,  0},
+        {0,  4,  0, 40,  4,  0},
+        {0,  4, 40,  0,  4,  0},
+        {0, 48,  2,  2,  0,  0},
+        {0,  0,  0,  0,  0,  0},
+    },
+    {
+        {0,  0,  0,  0,  0,  0},
+        {0,  0,  4,  4, 48,  0},
+        {0,  2,  0, 40,  2,  0},
+        {0,  2, 40,  0,  2,  0},
+        {0, 48,  4,  4,  0,  0},
+        {0,  0,  0,  0,  0,  0},
+    },
+};
+
+static const unsigned char gc_dot[2][6][6] = {
+    {
+        {0,  0,  0,  0,  0,  0},
+        {0, 48,  2,  2, 48, 50},
+        {0,  4, 40, 40,  4, 44},
+        {0,  4, 40, 40,  4, 44},
+        {0, 48,  2,  2, 48, 50},
+        {0, 52, 42, 42, 52,  0},
+    },
+    {
+        {0,  0,  0,  0,  0,  0},
+        {0, 48,  4,  4, 48, 52},
+        {0,  2, 40, 40,  2, 42},
+        {0,  2, 40, 40,  2, 42},
+        {0, 48,  4,  4, 48, 52},
+        {0, 50, 44, 44, 50,  0},
+    },
+};
+
+static inline int classMask(const unsigned char table[2][6][6], char ref, char alt, int rd){
+    
+    return table[rd][gc_base[(unsigned char)ref]][gc_base[(unsigned char)alt]];
+}
+
+#endif
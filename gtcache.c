@@ -0,0 +1,277 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Bit-packed genotype cache of a VCF file
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "gtcache.h"
+#include "contig.h"
+#include "vcf.h"
+#include "merge.h"
+#define merror "\nERROR: System out of memory\n"
+
+static const char cache_magic[4] = {'G', 'T', 'C', 1};
+
+int64_t cacheWrite(Bgzf_s *vcf_file, FILE *out){
+    
+    int i, k, n, samples=0, gt_max=0;
+    char *line=NULL, *p, *header=NULL, *field[10], buf[contig_buf], prev_buf[contig_buf];
+    unsigned char *a1=NULL, *a2=NULL;
+    size_t len=0;
+    ssize_t read;
+    uint64_t bit, prev=0;
+    CacheHead_s head;
+    Contig_s contig={0};
+    Row_s *row;
+    
+    memset(&head, 0, sizeof(CacheHead_s));
+    
+    while(bgzfPeek(vcf_file) == '#'){
+        if((read = bgzfGetline(&line, &len, vcf_file)) == -1)
+            break;
+        contigHeader(line);
+        if(strncmp(line, "#CHROM", 6) == 0){
+            for(p=line,i=0;(p=memchr(p, '\t', line + read - p)) != NULL;p++)
+                i++;
+            samples = i > 8 ? i - 8 : 0;
+            while(read > 0 && (line[read-1] == '\n' || line[read-1] == '\r'))
+                line[--read] = '\0';
+            free(header);
+            if((header = calloc(read + 8, 1)) == NULL){
+                fprintf(stderr,merror);
+                exit(EXIT_FAILURE);
+            }
+            memcpy(header, line, read);
+            head.names = (read + 8) & ~7;
+        }
+    }
+    
+    memcpy(head.magic, cache_magic, 4);
+    head.samples = samples;
+    head.words = (samples + 63) / 64;
+    
+    if((row = calloc(1, sizeof(Row_s) + 2*head.words*sizeof(uint64_t))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    fwrite(&head, sizeof(CacheHead_s), 1, out);
+    if(head.names > 0)
+        fwrite(header, head.names, 1, out);
+    
+    while((read = bgzfGetline(&line, &len, vcf_file)) != -1){
+        while(read > 0 && (line[read-1] == '\n' || line[read-1] == '\r'))
+            line[--read] = '\0';
+        if(line[0] == '#' || (k = vcfFields(line, line+read, field, 10)) < 5)
+            continue;
+        row->key = makeKey(contigLookup(&contig, line, field[1] - line - 1), atoi(field[1]));
+        if(row->key < prev){
+            fprintf(stderr,"\nERROR: The vcf-file is not sorted by chromosome and position (%s:%i after %s:%i)\n\n", contigName(keyChr(row->key), buf), keyPos(row->key), contigName(keyChr(prev), prev_buf), keyPos(prev));
+            exit(EXIT_FAILURE);
+        }
+        prev = row->key;
+        row->ref = field[3][0];
+        row->alt = field[4][0];
+        n = k == 10 ? vcfGenotypes(field[9], line+read, &a1, &a2, &gt_max) : 0;
+        row->n = n > samples ? samples : n;
+        memset(row->gt, 0, 2*head.words*sizeof(uint64_t));
+        for(i=0;i<row->n;i++){
+            bit = (uint64_t)1 << (i & 63);
+            if(a1[i] == '.' || a2[i] == '.'){
+                row->gt[i>>6] |= bit;
+                row->gt[head.words+(i>>6)] |= bit;
+            }
+            else if(a1[i] == '1' && a2[i] == '1')
+                row->gt[i>>6] |= bit;
+            else if(a1[i] != '0' || a2[i] != '0')
+                row->gt[head.words+(i>>6)] |= bit;
+        }
+        fwrite(row, sizeof(Row_s) + 2*head.words*sizeof(uint64_t), 1, out);
+        head.rec_n++;
+    }
+    
+    for(i=0,n=contigCount();i<n;i++){
+        p = (char *)contigName(contig_base + i, buf);
+        fwrite(p, strlen(p) + 1, 1, out);
+    }
+    
+    if(fseek(out, 0, SEEK_SET) != 0){
+        fprintf(stderr,"\nERROR: The genotype cache has to be written to a regular file\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    fwrite(&head, sizeof(CacheHead_s), 1, out);
+    
+    if(ferror(out)){
+        fprintf(stderr,"\nERROR: Cannot write the genotype cache\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    free(line);
+    free(a1);
+    free(a2);
+    free(row);
+    free(header);
+    
+    return head.rec_n;
+}
+
+Cache_s *cacheOpen(FILE *fp){
+    
+    int i;
+    const char *p, *q, *end;
+    struct stat st;
+    CacheHead_s *head;
+    Cache_s *cache;
+    
+    if(fstat(fileno(fp), &st) != 0 || S_ISREG(st.st_mode) == 0 || st.st_size < (off_t)sizeof(CacheHead_s))
+        return NULL;
+    
+    if((cache = calloc(1, sizeof(Cache_s))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    cache->size = st.st_size;
+    
+    if((cache->data = mmap(NULL, cache->size, PROT_READ, MAP_PRIVATE, fileno(fp), 0)) == MAP_FAILED){
+        free(cache);
+        return NULL;
+    }
+    
+    head = (CacheHead_s *)cache->data;
+    
+    if(memcmp(head->magic, cache_magic, 4) != 0){
+        munmap(cache->data, cache->size);
+        free(cache);
+        return NULL;
+    }
+    
+    cache->samples = head->samples;
+    cache->words = head->words;
+    cache->stride = sizeof(Row_s) + 2*head->words*sizeof(uint64_t);
+    cache->rec_n = head->rec_n;
+    cache->rows = cache->data + sizeof(CacheHead_s) + head->names;
+    cache->header = head->names > 0 ? (const char *)(cache->data + sizeof(CacheHead_s)) : NULL;
+    
+    if(sizeof(CacheHead_s) + head->names + cache->rec_n * cache->stride > cache->size){
+        fprintf(stderr,"\nERROR: The genotype cache is truncated\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    p = (const char *)cache->rows + cache->rec_n * cache->stride;
+    end = (const char *)cache->data + cache->size;
+    
+    for(i=0;p<end && (q = memchr(p, '\0', end - p)) != NULL;i++,p=q+1){
+        if(contigId(p, q - p) != contig_base + i){
+            fprintf(stderr,"\nERROR: The chromosome names of the genotype cache do not match those already read (open the cache before the other files)\n\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+    madvise(cache->data, cache->size, MADV_SEQUENTIAL);
+    
+    return cache;
+}
+
+void cacheClose(Cache_s *cache){
+    
+    munmap(cache->data, cache->size);
+    free(cache);
+}
+
+int64_t cacheFind(Cache_s *cache, int64_t i, int64_t last, uint64_t key){
+    
+    int64_t lo, hi, mid, step=1;
+    
+    if(i >= last || cacheRow(cache, i)->key >= key)
+        return i;
+    
+    lo = i;
+    while(lo + step < last && cacheRow(cache, lo + step)->key < key){
+        lo += step;
+        step <<= 1;
+    }
+    hi = lo + step < last ? lo + step : last;
+    
+    while(hi - lo > 1){
+        mid = lo + (hi - lo) / 2;
+        if(cacheRow(cache, mid)->key < key)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    
+    return hi;
+}
+
+int64_t cacheSplit(Cache_s *cache, int i, int n, int chrom){
+    
+    int64_t b;
+    
+    b = cache->rec_n * i / n;
+    
+    if(chrom && b > 0 && b < cache->rec_n)
+        b = cacheFind(cache, b, cache->rec_n, makeKey(keyChr(cacheRow(cache, b-1)->key) + 1, 0));
+    
+    return b;
+}
+
+void cacheCount(Cache_s *cache, Row_s *row, int *n00, int *n11, int *nmiss){
+    
+    int i, c00=0, c11=0, cm=0;
+    uint64_t *lo=row->gt, *hi=row->gt+cache->words;
+    
+    for(i=0;i<cache->words;i++){
+        c00 += __builtin_popcountll(lo[i] | hi[i]);
+        c11 += __builtin_popcountll(lo[i] & ~hi[i]);
+        cm += __builtin_popcountll(lo[i] & hi[i]);
+    }
+    
+    *n00 = row->n - c00;
+    *n11 = c11;
+    *nmiss = cm;
+}
+
+void cacheCountMask(Cache_s *cache, Row_s *row, uint64_t *mask, int *m, int *n00, int *n11, int *nmiss){
+    
+    int i, c=0, c00=0, c11=0, cm=0;
+    uint64_t *lo=row->gt, *hi=row->gt+cache->words, valid;
+    
+    for(i=0;i<cache->words;i++){
+        if(row->n >= (i + 1) * 64)
+            valid = ~(uint64_t)0;
+        else if(row->n > i * 64)
+            valid = ((uint64_t)1 << (row->n - i * 64)) - 1;
+        else
+            valid = 0;
+        c += __builtin_popcountll(mask[i] & valid);
+        c00 += __builtin_popcountll((lo[i] | hi[i]) & mask[i]);
+        c11 += __builtin_popcountll(lo[i] & ~hi[i] & mask[i]);
+        cm += __builtin_popcountll(lo[i] & hi[i] & mask[i]);
+    }
+    
+    *m = c;
+    *n00 = c - c00;
+    *n11 = c11;
+    *nmiss = cm;
+}
@@ -0,0 +1,67 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Bit-packed genotype cache of a VCF file
+ 
+ The cache holds one fixed-size row per VCF data line: the packed (chromosome, position) key, the first characters of REF and ALT, the number of genotypes, and two bit planes with one bit per sample each. 0/0 is stored as 00, 1/1 as 01 (low plane set), other called genotypes as 10 and genotypes with a missing allele as 11. Genotype columns beyond the samples named on the #CHROM line are ignored.
+ 
+ The #CHROM line is stored between the header and the rows (names is its padded length, 0 in caches made before it was kept), so sample groups can be matched against a cache. The names of the chromosomes that are not numbers follow the rows in the order of their ids (see contig.h), each ending in a zero byte, and are interned again when the cache is opened.
+ */
+
+#ifndef GTCACHE_H
+#define GTCACHE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "bgzf.h"
+
+typedef struct{
+    char magic[4];
+    int samples, words, names;
+    int64_t rec_n;
+}CacheHead_s;
+
+typedef struct{
+    uint64_t key;
+    char ref, alt;
+    short pad;
+    int n;
+    uint64_t gt[];
+}Row_s;
+
+typedef struct{
+    unsigned char *data, *rows;
+    const char *header;
+    size_t size;
+    int samples, words, stride;
+    int64_t rec_n;
+}Cache_s;
+
+int64_t cacheWrite(Bgzf_s *vcf_file, FILE *out);
+Cache_s *cacheOpen(FILE *fp);
+void cacheClose(Cache_s *cache);
+int64_t cacheFind(Cache_s *cache, int64_t i, int64_t last, uint64_t key);
+int64_t cacheSplit(Cache_s *cache, int i, int n, int chrom);
+void cacheCount(Cache_s *cache, Row_s *row, int *n00, int *n11, int *nmiss);
+void cacheCountMask(Cache_s *cache, Row_s *row, uint64_t *mask, int *m, int *n00, int *n11, int *nmiss);
+
+static inline Row_s *cacheRow(Cache_s *cache, int64_t i){
+    
+    return (Row_s *)(cache->rows + i * cache->stride);
+}
+
+#endif
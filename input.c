@@ -0,0 +1,132 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Single-pass loader for the tab-delimited input files
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "input.h"
+#define merror "\nERROR: System out of memory\n"
+#define chunk 1048576
+
+FILE *openInput(const char *name){
+    
+    if(strcmp(name, "-") == 0)
+        return stdin;
+    
+    return fopen(name, "r");
+}
+
+Map_s *mapFile(FILE *fp){
+    
+    struct stat st;
+    Map_s *map;
+    
+    if((map = calloc(1, sizeof(Map_s))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    map->fp = fp;
+    
+    if(fstat(fileno(fp), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0){
+        map->data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+        if(map->data != MAP_FAILED){
+            if(map->data[st.st_size-1] == '\n'){
+                madvise(map->data, st.st_size, MADV_SEQUENTIAL);
+                map->size = st.st_size;
+                map->end = map->data + map->size;
+                map->next = map->data;
+                map->mapped = 1;
+                return map;
+            }
+            munmap(map->data, st.st_size);
+        }
+        map->data = NULL;
+    }
+    
+    return map;
+}
+
+int mapLine(Map_s *map, char **line, char **eol){
+    
+    size_t n, left;
+    char *p;
+    
+    while(1){
+        if(map->next < map->end && (p = memchr(map->next, '\n', map->end - map->next)) != NULL){
+            *line = map->next;
+            *eol = p;
+            map->next = p + 1;
+            return 1;
+        }
+        if(map->mapped || map->eof)
+            return 0;
+        left = map->end - map->next;
+        if(left > 0)
+            memmove(map->data, map->next, left);
+        if(left + chunk + 1 > map->size){
+            map->size = (left + chunk + 1) * 2;
+            if((map->data = realloc(map->data, map->size)) == NULL){
+                fprintf(stderr,merror);
+                exit(EXIT_FAILURE);
+            }
+        }
+        n = fread(map->data + left, 1, chunk, map->fp);
+        map->next = map->data;
+        map->end = map->data + left + n;
+        if(n == 0){
+            map->eof = 1;
+            if(left > 0)
+                *map->end++ = '\n';
+        }
+    }
+}
+
+void unmapFile(Map_s *map){
+    
+    if(map->mapped)
+        munmap(map->data, map->size);
+    else
+        free(map->data);
+    
+    free(map);
+}
+
+char *nextField(char *p, char *eol){
+    
+    while(p < eol && *p != '\t')
+        p++;
+    while(p < eol && *p == '\t')
+        p++;
+    
+    return p;
+}
+
+void copyField(char *dest, char *p, int max){
+    
+    int i;
+    
+    for(i=0;i<max && p[i] != '\t' && p[i] != '\n' && p[i] != '\r';i++)
+        dest[i] = p[i];
+    
+    dest[i] = '\0';
+}
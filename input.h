@@ -0,0 +1,42 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Single-pass loader for the tab-delimited input files
+ 
+ Regular files are memory-mapped, other inputs (pipes, fifos and standard input given as '-') are read through a buffer that holds only the lines not yet parsed. Every line returned by mapLine ends with a newline, so fields can be parsed straight from it until the next call.
+ */
+
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdio.h>
+
+typedef struct{
+    FILE *fp;
+    char *data, *end, *next;
+    size_t size;
+    int mapped, eof;
+}Map_s;
+
+FILE *openInput(const char *name);
+Map_s *mapFile(FILE *fp);
+int mapLine(Map_s *map, char **line, char **eol);
+void unmapFile(Map_s *map);
+char *nextField(char *p, char *eol);
+void copyField(char *dest, char *p, int max);
+
+#endif
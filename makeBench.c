@@ -0,0 +1,391 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Program for generating synthetic input files and timing the readers of estDAF and makeDFE-alpha
+ 
+ compiling: gcc -O2 makeBench.c mummer.c contig.c merge.c input.c -o makeBench -lpthread
+ 
+ usage:
+ -out [prefix] prefix for the generated files (prefix.coord, prefix.snps, prefix.sites, prefix.genes, prefix.full.vcf, prefix.poly.vcf and prefix.empty.vcf)
+ -chr [int] number of chromosomes (default 5)
+ -length [int] length of each chromosome in bp, the full vcf-file has one line per bp (default 100000)
+ -samples [int] number of samples (default 50)
+ -missing [float] proportion of missing genotypes (default 0.05)
+ -div [float] proportion of sites that differ from the outgroup (default 0.02)
+ -poly [float] proportion of polymorphic sites (default 0.1)
+ -sites [float] proportion of sites written to the sites file (default 0.3)
+ -seed [int] seed for generating the data (default 1)
+ -tools [dir] directory with the estDAF and makeDFE-alpha binaries, times the full programs as well (optional)
+ -repeat [int] number of times each measurement is repeated, the fastest is reported (default 3)
+ 
+ example:
+ ./makeBench -out bench -chr 5 -length 200000 -samples 100 -tools .
+ 
+ The timings are written to standard output as tab-delimited lines with phase, seconds, items, items per second and MB per second. readCoord and readDiv are timed in this program. With -tools, the program runs are timed once with an empty vcf-file, which covers the loading of the other files, and once with the full or polymorphic vcf-file; readSites is the makeDFE-alpha loading time minus readCoord and readDiv, and readVcf the difference between the two runs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "merge.h"
+#include "mummer.h"
+#define merror "\nERROR: System out of memory\n"
+
+typedef struct{
+    int chr_n, length, samples, repeat;
+    double missing, div, poly, sites;
+    uint64_t seed;
+    char *prefix, *tools;
+}Bench_s;
+
+void openFiles(int argc, char *argv[]);
+void makeData(Bench_s *bench);
+double timeReaders(Bench_s *bench, int div);
+double timeRun(Bench_s *bench, const char *command);
+void printTime(const char *phase, double sec, double items, const char *name, Bench_s *bench);
+uint64_t hashSite(uint64_t seed, int chr, int pos, int salt);
+double nowSec(void);
+FILE *openOut(Bench_s *bench, const char *suffix);
+
+int main(int argc, char *argv[]){
+    
+    openFiles(argc, argv);
+    
+    return 0;
+}
+
+void openFiles(int argc, char *argv[]){
+    
+    int i;
+    double load, full, coord_t, div_t;
+    char *command;
+    Bench_s bench={5, 100000, 50, 3, 0.05, 0.02, 0.1, 0.3, 1, NULL, NULL};
+    
+    fprintf(stderr,"\nParameters:\n");
+    
+    for(i=1;i<argc;i++){
+        
+        if(i + 1 == argc){
+            fprintf(stderr,"\nERROR: No value given for '%s'\n\n", argv[i]);
+            exit(EXIT_FAILURE);
+        }
+        
+        if(strcmp(argv[i], "-out") == 0)
+            bench.prefix = argv[++i];
+        else if(strcmp(argv[i], "-chr") == 0)
+            bench.chr_n = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-length") == 0)
+            bench.length = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-samples") == 0)
+            bench.samples = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-missing") == 0)
+            bench.missing = atof(argv[++i]);
+        else if(strcmp(argv[i], "-div") == 0)
+            bench.div = atof(argv[++i]);
+        else if(strcmp(argv[i], "-poly") == 0)
+            bench.poly = atof(argv[++i]);
+        else if(strcmp(argv[i], "-sites") == 0)
+            bench.sites = atof(argv[++i]);
+        else if(strcmp(argv[i], "-seed") == 0)
+            bench.seed = strtoull(argv[++i], NULL, 10);
+        else if(strcmp(argv[i], "-tools") == 0)
+            bench.tools = argv[++i];
+        else if(strcmp(argv[i], "-repeat") == 0)
+            bench.repeat = atoi(argv[++i]);
+        else{
+            fprintf(stderr,"\nERROR: Unknown argument '%s'\n\n", argv[i]);
+            exit(EXIT_FAILURE);
+        }
+        fprintf(stderr,"\t%s %s\n", argv[i-1], argv[i]);
+    }
+    
+    fprintf(stderr,"\n");
+    
+    if(bench.prefix == NULL){
+        fprintf(stderr,"ERROR: The following parameters are required: -out [prefix]\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    if(bench.chr_n < 1 || bench.length < 1 || bench.samples < 1 || bench.repeat < 1){
+        fprintf(stderr,"ERROR: -chr, -length, -samples and -repeat must be at least 1\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    makeData(&bench);
+    
+    printf("phase\tseconds\titems\titems_per_sec\tMB_per_sec\n");
+    
+    coord_t = timeReaders(&bench, 0);
+    div_t = timeReaders(&bench, 1);
+    
+    if(bench.tools == NULL)
+        return;
+    
+    if((command = malloc(8*strlen(bench.prefix)+strlen(bench.tools)+200)) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    sprintf(command, "%s/makeDFE-alpha -coord %s.coord -div %s.snps -sites %s.sites -vcf %s.empty.vcf -gc 0", bench.tools, bench.prefix, bench.prefix, bench.prefix, bench.prefix);
+    load = timeRun(&bench, command);
+    sprintf(command, "%s/makeDFE-alpha -coord %s.coord -div %s.snps -sites %s.sites -vcf %s.full.vcf -gc 0", bench.tools, bench.prefix, bench.prefix, bench.prefix, bench.prefix);
+    full = timeRun(&bench, command);
+    printTime("makeDFE-alpha.readSites", load - coord_t - div_t, (double)bench.chr_n*bench.length*bench.sites, "sites", &bench);
+    printTime("makeDFE-alpha.readVcf", full - load, (double)bench.chr_n*bench.length, "full.vcf", &bench);
+    printTime("makeDFE-alpha.total", full, (double)bench.chr_n*bench.length, "full.vcf", &bench);
+    
+    sprintf(command, "%s/estDAF -coord %s.coord -div %s.snps -genes %s.genes -vcf %s.empty.vcf -gc 0", bench.tools, bench.prefix, bench.prefix, bench.prefix, bench.prefix);
+    load = timeRun(&bench, command);
+    sprintf(command, "%s/estDAF -coord %s.coord -div %s.snps -genes %s.genes -vcf %s.poly.vcf -gc 0", bench.tools, bench.prefix, bench.prefix, bench.prefix, bench.prefix);
+    full = timeRun(&bench, command);
+    printTime("estDAF.readVcf", full - load, (double)bench.chr_n*bench.length*bench.poly, "poly.vcf", &bench);
+    printTime("estDAF.total", full, (double)bench.chr_n*bench.length*bench.poly, "poly.vcf", &bench);
+    
+    free(command);
+}
+
+void makeData(Bench_s *bench){
+    
+    int c, p, i, s, e, k, poly, gt_len;
+    char ref, alt, *gt;
+    const char *bases="ACGT";
+    uint64_t h;
+    FILE *coord_file, *div_file, *site_file, *gene_file, *full_file, *poly_file, *empty_file;
+    
+    coord_file = openOut(bench, "coord");
+    div_file = openOut(bench, "snps");
+    site_file = openOut(bench, "sites");
+    gene_file = openOut(bench, "genes");
+    full_file = openOut(bench, "full.vcf");
+    poly_file = openOut(bench, "poly.vcf");
+    empty_file = openOut(bench, "empty.vcf");
+    
+    gt_len = 4*bench->samples;
+    
+    if((gt = malloc(gt_len+1)) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    fprintf(full_file,"##fileformat=VCFv4.2\n#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT");
+    fprintf(poly_file,"##fileformat=VCFv4.2\n#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT");
+    fprintf(empty_file,"##fileformat=VCFv4.2\n#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT");
+    for(i=0;i<bench->samples;i++){
+        fprintf(full_file,"\ts%i", i);
+        fprintf(poly_file,"\ts%i", i);
+        fprintf(empty_file,"\ts%i", i);
+    }
+    fprintf(full_file,"\n");
+    fprintf(poly_file,"\n");
+    fprintf(empty_file,"\n");
+    
+    for(c=1;c<=bench->chr_n;c++){
+        for(p=1,k=0;p<bench->length;k++){
+            h = hashSite(bench->seed, c, k, 1);
+            s = p + h % 300;
+            e = s + 500 + (h >> 16) % 2500;
+            if(e > bench->length)
+                e = bench->length;
+            if(s <= e)
+                fprintf(coord_file,"%i\t%i\t%i\t%i\t%i\t%i\t99.00\t%i\tscaf%i\n", s, e, s, e, e-s+1, e-s+1, c, c);
+            p = e + 1;
+        }
+        for(p=1,k=0;p<bench->length;k++){
+            h = hashSite(bench->seed, c, k, 2);
+            s = p + 10 + h % 490;
+            e = s + 200 + (h >> 16) % 1300;
+            if(e > bench->length)
+                e = bench->length;
+            if(s <= e)
+                fprintf(gene_file,"AT%iG%05i\t%i\t%i\t%i\n", c, k, c, s, e);
+            p = e + 1;
+        }
+        for(p=1;p<=bench->length;p++){
+            h = hashSite(bench->seed, c, p, 0);
+            ref = bases[h & 3];
+            alt = bases[((h & 3) + 1 + (h >> 2) % 3) & 3];
+            if((double)(h >> 11 & 0xfffff) / 0x100000 < bench->div)
+                fprintf(div_file,"%i\t%c\t%c\t%i\t10\t10\t1\t1\t%i\tscaf%i\n", p, ref, alt, p, c, c);
+            if((double)(hashSite(bench->seed, c, p, 3) >> 11) / 9007199254740992.0 < bench->sites)
+                fprintf(site_file,"%i\t%i\n", c, p);
+            poly = (double)(h >> 31 & 0xfffff) / 0x100000 < bench->poly;
+            for(i=0;i<bench->samples;i++){
+                h = hashSite(bench->seed ^ (uint64_t)i << 40, c, p, 4);
+                gt[4*i] = '\t';
+                if((double)(h >> 11) / 9007199254740992.0 < bench->missing)
+                    memcpy(gt+4*i+1, "./.", 3);
+                else if(poly && (h & 3) == 0)
+                    memcpy(gt+4*i+1, "1/1", 3);
+                else
+                    memcpy(gt+4*i+1, "0/0", 3);
+            }
+            gt[gt_len] = '\0';
+            fprintf(full_file,"%i\t%i\t.\t%c\t%c\t50\tPASS\t.\tGT%s\n", c, p, ref, poly ? alt : '.', gt);
+            if(poly)
+                fprintf(poly_file,"%i\t%i\t.\t%c\t%c\t50\tPASS\t.\tGT%s\n", c, p, ref, alt, gt);
+        }
+    }
+    
+    free(gt);
+    fclose(coord_file);
+    fclose(div_file);
+    fclose(site_file);
+    fclose(gene_file);
+    fclose(full_file);
+    fclose(poly_file);
+    fclose(empty_file);
+}
+
+double timeReaders(Bench_s *bench, int div){
+    
+    int i, n=0;
+    double start, sec=-1;
+    char *name;
+    FILE *fp;
+    Keys_s *keys;
+    Site_s *list;
+    
+    if((name = malloc(strlen(bench->prefix)+10)) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    sprintf(name, "%s.%s", bench->prefix, div ? "snps" : "coord");
+    
+    for(i=0;i<bench->repeat;i++){
+        if((fp = fopen(name, "r")) == NULL){
+            fprintf(stderr,"ERROR: Cannot open file %s\n\n", name);
+            exit(EXIT_FAILURE);
+        }
+        start = nowSec();
+        if(div){
+            keys = keysInit(1, 0);
+            list = readDiv(fp, NULL, keys);
+            free(list);
+        }
+        else
+            keys = readCoord(fp);
+        if(sec < 0 || nowSec() - start < sec)
+            sec = nowSec() - start;
+        n = keys->n;
+        keysFree(keys);
+    }
+    
+    printTime(div ? "readDiv" : "readCoord", sec, n, div ? "snps" : "coord", bench);
+    
+    free(name);
+    
+    return sec;
+}
+
+double timeRun(Bench_s *bench, const char *command){
+    
+    int i;
+    double start, sec=-1;
+    char *line;
+    
+    if((line = malloc(strlen(command)+30)) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    sprintf(line, "%s > /dev/null 2>&1", command);
+    
+    for(i=0;i<bench->repeat;i++){
+        start = nowSec();
+        if(system(line) != 0){
+            fprintf(stderr,"ERROR: Command failed: %s\n\n", command);
+            exit(EXIT_FAILURE);
+        }
+        if(sec < 0 || nowSec() - start < sec)
+            sec = nowSec() - start;
+    }
+    
+    free(line);
+    
+    return sec;
+}
+
+void printTime(const char *phase, double sec, double items, const char *name, Bench_s *bench){
+    
+    double mb=0;
+    char *file;
+    struct stat st;
+    
+    if((file = malloc(strlen(bench->prefix)+20)) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    sprintf(file, "%s.%s", bench->prefix, name);
+    
+    if(stat(file, &st) == 0)
+        mb = st.st_size / 1048576.0;
+    
+    if(sec < 1e-9)
+        sec = 1e-9;
+    
+    printf("%s\t%.6f\t%.0f\t%.0f\t%.2f\n", phase, sec, items, items / sec, mb / sec);
+    fflush(stdout);
+    
+    free(file);
+}
+
+uint64_t hashSite(uint64_t seed, int chr, int pos, int salt){
+    
+    uint64_t z;
+    
+    z = seed + ((uint64_t)(uint32_t)chr << 32 | (uint32_t)pos) * 0x9e3779b97f4a7c15ULL + (uint64_t)salt * 0xd1b54a32d192ed03ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    
+    return z ^ (z >> 31);
+}
+
+double nowSec(void){
+    
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+FILE *openOut(Bench_s *bench, const char *suffix){
+    
+    char *name;
+    FILE *fp;
+    
+    if((name = malloc(strlen(bench->prefix)+strlen(suffix)+2)) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    sprintf(name, "%s.%s", bench->prefix, suffix);
+    
+    if((fp = fopen(name, "w")) == NULL){
+        fprintf(stderr,"ERROR: Cannot open file %s\n\n", name);
+        exit(EXIT_FAILURE);
+    }
+    
+    free(name);
+    
+    return fp;
+}
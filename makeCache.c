@@ -0,0 +1,162 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Program for converting a vcf-file into the bit-packed genotype cache, or the MUMmer alignments into the binary coordinate and substitution caches, read by estDAF and makeDFE-alpha
+ 
+ compiling: gcc -O2 makeCache.c gtcache.c bgzf.c vcf.c mummer.c contig.c merge.c input.c -o makeCache -lpthread -lz
+ 
+ usage:
+ -vcf [file] vcf-file, plain or compressed with bgzip (use - for standard input)
+ -coord [file] coordinates file produced by 'show-coords' program from MUMmer (use settings -H -T)
+ -div [file] substitution file produced by 'show-snps' program from MUMmer (use settings -C -I -H -T)
+ -out [file] name of the cache file
+ 
+ example:
+ ./makeCache -vcf thaliana.full.vcf.gz -out thaliana.full.gtc
+ ./makeCache -coord thaliana-lyrata.filt.coord -out thaliana-lyrata.filt.coord.bin
+ ./makeCache -div thaliana-lyrata.filt.snps -out thaliana-lyrata.filt.snps.bin
+ ./makeDFE-alpha -coord thaliana-lyrata.filt.coord.bin -div thaliana-lyrata.filt.snps.bin -sites 4fold.sites -vcf thaliana.full.gtc -gc 1 > out.4fold.WS.txt
+ 
+ Only the first characters of REF and ALT and the two alleles of each genotype are kept, so the cache gives the same results as the vcf-file it was made from. The #CHROM line and the chromosome names are stored as well, so -pops and named chromosomes work with the cache. Lines must be sorted by chromosome and position, and the alignment caches are written sorted.
+ 
+ Only one of -vcf, -coord and -div is converted per run. The alignment caches keep every alignment and substitution of the text files and are checked against a checksum when read.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "bgzf.h"
+#include "gtcache.h"
+#include "input.h"
+#include "mummer.h"
+
+void openFiles(int argc, char *argv[]);
+
+int main(int argc, char *argv[]){
+    
+    int second=0, minute=0, hour=0;
+    time_t timer=0;
+    
+    timer = time(NULL);
+    
+    openFiles(argc, argv);
+    
+    second = time(NULL) - timer;
+    
+    minute = second / 60;
+    
+    hour = second / 3600;
+    
+    if(isatty(1))
+        fprintf(stderr,"\n");
+    
+    if(hour > 0)
+        fprintf(stderr,"Run finished in %i h, %i min & %i sec\n\n", hour, minute-hour*60, second-minute*60);
+    else if(minute > 0)
+        fprintf(stderr,"Run finished in %i min & %i sec\n\n", minute, second-minute*60);
+    else if(second > 5)
+        fprintf(stderr,"Run finished in %i sec\n\n", second);
+    else
+        fprintf(stderr,"\n");
+    
+    return 0;
+}
+
+void openFiles(int argc, char *argv[]){
+    
+    int i;
+    int64_t rec_n;
+    FILE *out_file=NULL, *coord_file=NULL, *div_file=NULL;
+    Bgzf_s *vcf_file=NULL;
+    Keys_s *keys;
+    Site_s *div;
+    
+    fprintf(stderr,"\nParameters:\n");
+    
+    for(i=1;i<argc;i++){
+        
+        if(strcmp(argv[i], "-vcf") == 0){
+            if((vcf_file = bgzfOpen(argv[++i])) == NULL){
+                fprintf(stderr,"\nERROR: Cannot open file %s\n\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr,"\t-vcf %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-coord") == 0){
+            if((coord_file = openInput(argv[++i])) == NULL){
+                fprintf(stderr,"\nERROR: Cannot open file %s\n\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr,"\t-coord %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-div") == 0){
+            if((div_file = openInput(argv[++i])) == NULL){
+                fprintf(stderr,"\nERROR: Cannot open file %s\n\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr,"\t-div %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-out") == 0){
+            if((out_file = fopen(argv[++i], "wb")) == NULL){
+                fprintf(stderr,"\nERROR: Cannot open file %s\n\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr,"\t-out %s\n", argv[i]);
+        }
+        
+        else{
+            fprintf(stderr,"\nERROR: Unknown argument '%s'\n\n", argv[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+    fprintf(stderr,"\n");
+    
+    if((vcf_file != NULL) + (coord_file != NULL) + (div_file != NULL) != 1 || out_file == NULL){
+        fprintf(stderr,"ERROR: The following parameters are required: -vcf [file], -coord [file] or -div [file], and -out [file]\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    if(vcf_file != NULL){
+        rec_n = cacheWrite(vcf_file, out_file);
+        fprintf(stderr,"Wrote %lld sites\n", (long long)rec_n);
+        bgzfClose(vcf_file);
+    }
+    
+    else if(coord_file != NULL){
+        keys = readCoord(coord_file);
+        writeCoord(keys, out_file);
+        fprintf(stderr,"Wrote %i alignments\n", keys->n);
+        keysFree(keys);
+    }
+    
+    else{
+        keys = keysInit(1, 0);
+        div = readDiv(div_file, NULL, keys);
+        writeDiv(keys, div, out_file);
+        fprintf(stderr,"Wrote %i substitutions\n", keys->n);
+        keysFree(keys);
+        free(div);
+    }
+    
+    fclose(out_file);
+}
@@ -17,46 +17,61 @@
  
  Program for producing SFS and divergence-counts reguired by DFE-alpha
  
- compiling: gcc makeDFE-alpha.c -o makeDFE-alpha -lm
+ compiling: gcc -O2 makeDFE-alpha.c sfs.c scan.c bgzf.c vcf.c input.c merge.c gtcache.c pops.c mummer.c contig.c tally.c stats.c -o makeDFE-alpha -lm -lpthread -lz (add -march=native to scan genotypes with AVX2)
+ 
+ or against the shared library: gcc -O2 makeDFE-alpha.c -o makeDFE-alpha -L. -lgcbias (see gcbias.h)
  
  usage:
- -coord [file] coordinates file produced by 'show-coords' program from MUMmer (use settings -H -T)
- -div [file] substitution file produced by 'show-snps' program from MUMmer (use settings -C -I -H -T)
+ -coord [file] coordinates file produced by 'show-coords' program from MUMmer (use settings -H -T), or a coordinate cache made with makeCache
+ -div [file] substitution file produced by 'show-snps' program from MUMmer (use settings -C -I -H -T), or a substitution cache made with makeCache
  -sites [file] tab-delimited file with chromosome and postition (0-fold or 4-fold)
- -vcf [file] full vcf-file containing variant and invariant sites
+ -vcf [file] full vcf-file containing variant and invariant sites, plain or compressed with bgzip (a .tbi or .csi index is used to read only the blocks with selected sites), or a genotype cache made with makeCache
  -region [file] tab-delimited file with chromosome, start, and end for regions to use (optional)
- -gc [int] different DAF-classes 1 [WS] 2 [SW] 3 [SS] 4 [WW] 5 [SS+WW]
+ -genes [file] tab-delimited file with name, chromosome, start, and end for each gene (genes may overlap or nest, and each gets every site it contains), writes the SFS and sites/divergence counts of each gene on its own line instead of the genome-wide counts (optional)
+ -window [int] writes the SFS and sites/divergence counts of sliding windows of this length along each chromosome on their own lines, each starting with chromosome, start and end (optional, cannot be combined with -genes)
+ -step [int] distance between the starts of consecutive windows (default the window length)
+ -ploidy [int] counts alleles instead of homozygous individuals, for calls with this many sets of chromosomes (2 for diploids with heterozygous calls and more for polyploids, which need a vcf-file instead of a genotype cache; only the 0 and 1 alleles of a call are counted, and the program stops at a call of the vcf-file with another number of alleles, optional)
+ -pops [file] tab-delimited file with sample name and group for each sample to use, writes the counts of each group to prefix.group.class.txt (requires -out, optional)
+ -gc [int] different DAF-classes 1 [WS] 2 [SW] 3 [SS] 4 [WW] 5 [SS+WW], or 'all' for every class in a single pass
+ -out [prefix] prefix for the output files when using -gc all (prefix.all.txt, prefix.WS.txt, prefix.SW.txt, prefix.SS.txt, prefix.WW.txt, prefix.SSWW.txt)
+ -mismatch [file] writes the chromosome and position of every site where the reference base of the vcf-file and the substitution file differ (optional, a summary for each chromosome is always printed)
+ -stats [file] writes the time spent in each phase and counts of the lines and sites read as tab-delimited name and value (optional)
+ -threads [int] number of chromosomes processed in parallel (requires a regular or indexed vcf-file or a genotype cache, default 1)
+ -parse-threads [int] number of threads parsing the lines of each chromosome, next to one thread reading and one counting them (vcf-file only, default 0)
+ -dense keeps the substitutions as a bitmap of each chromosome instead of a sorted list, for constant-time lookups (needs A, C, G and T bases, optional)
+ -project [int] projects the SFS of each site down to this many genotypes (alleles with -ploidy) by hypergeometric sampling instead of imputing the missing genotypes, leaving out sites with fewer calls and writing the SFS with two decimals (optional, cannot be combined with -genes or -window)
+ -bootstrap [int] number of block-bootstrap replicates, each written after the observed counts as its own SFS and sites/divergence lines (optional)
+ -block-size [int] length of the bootstrap blocks in bp (default 100000)
+ -seed [int] seed for drawing the bootstrap blocks (default 1)
+ -save-counts [file] saves the genotype counts of each group at every aligned site of the vcf-file, added to those of -add-counts (optional)
+ -add-counts [file] counts saved with -save-counts by an earlier run, to which the samples of -vcf are added, or which are used instead of a vcf-file when -vcf is not given (optional)
  
  example:
  ./makeDFE-alpha -coord thaliana-lyrata.filt.coord -div thaliana-lyrata.filt.snps -sites 4fold.sites -vcf thaliana.full.vcf -gc 1 > out.4fold.WS.txt
+ ./makeDFE-alpha -coord thaliana-lyrata.filt.coord -div thaliana-lyrata.filt.snps -sites 4fold.sites -vcf thaliana.full.vcf -gc all -out out.4fold
+ ./makeDFE-alpha -coord thaliana-lyrata.filt.coord -div thaliana-lyrata.filt.snps -sites 4fold.sites -vcf thaliana.full.vcf -gc 1 -bootstrap 1000 -block-size 100000 -threads 8 > out.4fold.WS.boot.txt
+ ./makeDFE-alpha -coord thaliana-lyrata.filt.coord -div thaliana-lyrata.filt.snps -sites 4fold.sites -vcf thaliana.full.vcf -gc all -pops thaliana.pops.txt -out out.4fold
+ ./makeDFE-alpha -coord thaliana-lyrata.filt.coord -div thaliana-lyrata.filt.snps -sites 4fold.sites -vcf thaliana.full.vcf -gc 1 -window 100000 -step 10000 > out.4fold.WS.windows.txt
+ ./makeDFE-alpha -coord thaliana-lyrata.filt.coord -div thaliana-lyrata.filt.snps -sites 0fold.sites -add-counts panel.counts -gc 1 > out.0fold.WS.txt
+ 
+ Windows are counted in one pass: each site is added when the scan reaches it and removed when the window start passes it, so the work grows with the number of sites and not with the number of windows. Only windows with at least one site are written, and the last windows of a chromosome may extend past its end.
+ 
+ With -save-counts and -add-counts, a panel that grows in batches of samples is counted incrementally: each run reads only the vcf-file of the new samples (with a -pops file naming the same groups in the same order, whose samples missing from the vcf-file are taken to be in other batches) and adds its counts to the saved ones, site by site. The counts are saved for every aligned site and not only for -sites, and the sites, regions, classes, substitutions, genes and windows are applied to them in each run, so a refined site list is counted again from the saved counts alone. The results are the same as from one vcf-file with all samples, except at sites missing from some of the batches, which count as not called in their samples. The same -ploidy has to be used in every run, and the file can be both read and saved in one run.
  
- The program was written for A.thaliana data. It assumes that all files are sorted by chromosome and position, chromosomes are identified with numbers (e.g. 1 and not chr1), and VCF-file contains no heterozygote sites.
+ One input file can be given as '-' to read it from standard input, and inputs can also be named pipes (e.g. bcftools view ... | ./makeDFE-alpha -vcf - ...). Index seeking, -threads and the caches made with makeCache need a regular file.
+ 
+ The program was written for A.thaliana data. The coordinate, substitution, gene, region and site files are sorted in memory when they are out of order, but the vcf-file has to be sorted by chromosome and position (the program stops if it is not). Chromosomes can be numbers or names (1, chr1 or scaffold_12), and numbered chromosomes come before named ones, which follow the ##contig lines of the vcf-file, its index or cache, or the order of a regular vcf-file (from a pipe without ##contig lines, the order in which the other files first name them). VCF-file contains no heterozygote sites (unless -ploidy is given).
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
 #include <unistd.h>
 #include <time.h>
+#include "gcbias.h"
 #define merror "\nERROR: System out of memory\n"
 
-typedef struct{
-    int chr, start, stop;
-}Region_s;
-
-typedef struct{
-    int chr, pos;
-    char ref, alt;
-}Site_s;
-
 void openFiles(int argc, char *argv[]);
-Region_s *readCoord(FILE *coord_file, int *n);
-Region_s *readTarget(FILE *target_file, int *n);
-int **readSites(FILE *site_file, Region_s *coords, Region_s *target, int coord_n, int target_n, int *n);
-Site_s *readDiv(FILE *div_file, int **sites, int site_n, int *n);
-void readVcf(FILE *vcf_file, int **sites, Site_s *div, int gc, int site_n, int div_n);
-void lineTerminator(char *line);
 
 int main(int argc, char *argv[]){
     
@@ -90,18 +105,40 @@ int main(int argc, char *argv[]){
 
 void openFiles(int argc, char *argv[]){
     
-    int i, gc=0, coord_n=0, div_n=0, site_n=0, target_n=0, **sites;
-    char **list;
-    FILE *vcf_file=NULL, *coord_file=NULL, *div_file=NULL, *site_file=NULL, *target_file=NULL;
-    Region_s *coords, *target;
+    int i, g, gc=0, std_n=0, threads=1, boot_n=0, block_size=100000, grp_n=1, win_size=0, win_step=0, ploidy=0, project=0, use=0, parsers=0, dense_on=0;
+    uint64_t seed=1;
+    char *prefix=NULL, *name=NULL, *vcf_name=NULL, *save_name=NULL;
+    FILE *coord_file=NULL, *div_file=NULL, *site_file=NULL, *target_file=NULL, *gene_file=NULL, *pop_file=NULL, *add_file=NULL, *save_file, **out;
+    Pops_s *pops=NULL;
+    Keys_s *coords, *target=NULL, *sites, *div_keys, *gene_keys=NULL;
+    Region_s *genes=NULL;
     Site_s *div;
+    Dense_s *dense=NULL;
+    Bgzf_s *vcf_file=NULL;
+    FILE *stats_file=NULL, *mis_file=NULL;
+    Stats_s stats;
+    Tally_s *tally=NULL, *batch;
+    Source_s *src=NULL;
+    Sfs_s *sfs;
+    
+    statsInit(&stats);
+    
+    for(i=1;i<argc;i++){
+        if(strcmp(argv[i], "-") == 0)
+            std_n++;
+    }
+    
+    if(std_n > 1){
+        fprintf(stderr,"\nERROR: Only one input can be read from standard input\n\n");
+        exit(EXIT_FAILURE);
+    }
     
     fprintf(stderr,"\nParameters:\n");
     
     for(i=1;i<argc;i++){
         
         if(strcmp(argv[i], "-coord") == 0){
-            if((coord_file = fopen(argv[++i], "r")) == NULL){
+            if((coord_file = openInput(argv[++i])) == NULL){
                 fprintf(stderr,"\nERROR: Cannot open file %s\n\n", argv[i]);
                 exit(EXIT_FAILURE);
             }
@@ -109,7 +146,7 @@ void openFiles(int argc, char *argv[]){
         }
         
         else if(strcmp(argv[i], "-div") == 0){
-            if((div_file = fopen(argv[++i], "r")) == NULL){
+            if((div_file = openInput(argv[++i])) == NULL){
                 fprintf(stderr,"\nERROR: Cannot open file %s\n\n", argv[i]);
                 exit(EXIT_FAILURE);
             }
@@ -117,7 +154,7 @@ void openFiles(int argc, char *argv[]){
         }
         
         else if(strcmp(argv[i], "-sites") == 0){
-            if((site_file = fopen(argv[++i], "r")) == NULL){
+            if((site_file = openInput(argv[++i])) == NULL){
                 fprintf(stderr,"\nERROR: Cannot open file %s\n\n", argv[i]);
                 exit(EXIT_FAILURE);
             }
@@ -125,30 +162,167 @@ void openFiles(int argc, char *argv[]){
         }
         
         else if(strcmp(argv[i], "-vcf") == 0){
-            if((vcf_file = fopen(argv[++i], "r")) == NULL){
+            if((vcf_file = bgzfOpen(argv[++i])) == NULL){
                 fprintf(stderr,"\nERROR: Cannot open file %s\n\n", argv[i]);
                 exit(EXIT_FAILURE);
             }
+            vcf_name = argv[i];
             fprintf(stderr,"\t-vcf %s\n", argv[i]);
         }
         
         else if(strcmp(argv[i], "-region") == 0){
-            if((target_file = fopen(argv[++i], "r")) == NULL){
+            if((target_file = openInput(argv[++i])) == NULL){
                 fprintf(stderr,"\nERROR: Cannot open file %s\n\n", argv[i]);
                 exit(EXIT_FAILURE);
             }
             fprintf(stderr,"\t-region %s\n", argv[i]);
         }
         
-        else if(strcmp(argv[i], "-gc") == 0){
-            gc = atoi(argv[++i]);
-            if(gc < 0 || gc > 5){
-                fprintf(stderr,"\nERROR: allowed values for -gc are 1 [WS], 2 [SW] 3 [SS] 4 [WW] 5 [SS+WW]\n\n", argv[i]);
+        else if(strcmp(argv[i], "-genes") == 0){
+            if((gene_file = openInput(argv[++i])) == NULL){
+                fprintf(stderr,"\nERROR: Cannot open file %s\n\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr,"\t-genes %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-window") == 0){
+            win_size = atoi(argv[++i]);
+            if(win_size < 1){
+                fprintf(stderr,"\nERROR: -window must be at least 1\n\n");
                 exit(EXIT_FAILURE);
             }
+            fprintf(stderr,"\t-window %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-step") == 0){
+            win_step = atoi(argv[++i]);
+            if(win_step < 1){
+                fprintf(stderr,"\nERROR: -step must be at least 1\n\n");
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr,"\t-step %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-ploidy") == 0){
+            ploidy = atoi(argv[++i]);
+            if(ploidy < 2 || ploidy > 254){
+                fprintf(stderr,"\nERROR: -ploidy must be between 2 and 254\n\n");
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr,"\t-ploidy %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-pops") == 0){
+            if((pop_file = openInput(argv[++i])) == NULL){
+                fprintf(stderr,"\nERROR: Cannot open file %s\n\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr,"\t-pops %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-gc") == 0){
+            if(strcmp(argv[++i], "all") == 0)
+                gc = -1;
+            else{
+                gc = atoi(argv[i]);
+                if(gc < 0 || gc > 5){
+                    fprintf(stderr,"\nERROR: allowed values for -gc are 1 [WS], 2 [SW] 3 [SS] 4 [WW] 5 [SS+WW] or all\n\n");
+                    exit(EXIT_FAILURE);
+                }
+            }
             fprintf(stderr,"\t-gc %s\n", argv[i]);
         }
         
+        else if(strcmp(argv[i], "-out") == 0){
+            prefix = argv[++i];
+            fprintf(stderr,"\t-out %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-mismatch") == 0){
+            if((mis_file = fopen(argv[++i], "w")) == NULL){
+                fprintf(stderr,"\nERROR: Cannot open file %s\n\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr,"\t-mismatch %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-stats") == 0){
+            if((stats_file = fopen(argv[++i], "w")) == NULL){
+                fprintf(stderr,"\nERROR: Cannot open file %s\n\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr,"\t-stats %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-dense") == 0){
+            dense_on = 1;
+            fprintf(stderr,"\t-dense\n");
+        }
+        
+        else if(strcmp(argv[i], "-threads") == 0){
+            threads = atoi(argv[++i]);
+            if(threads < 1){
+                fprintf(stderr,"\nERROR: -threads must be at least 1\n\n");
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr,"\t-threads %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-save-counts") == 0){
+            save_name = argv[++i];
+            fprintf(stderr,"\t-save-counts %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-add-counts") == 0){
+            if((add_file = openInput(argv[++i])) == NULL){
+                fprintf(stderr,"\nERROR: Cannot open file %s\n\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr,"\t-add-counts %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-parse-threads") == 0){
+            parsers = atoi(argv[++i]);
+            if(parsers < 0){
+                fprintf(stderr,"\nERROR: -parse-threads must be at least 0\n\n");
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr,"\t-parse-threads %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-project") == 0){
+            project = atoi(argv[++i]);
+            if(project < 1){
+                fprintf(stderr,"\nERROR: -project must be at least 1\n\n");
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr,"\t-project %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-bootstrap") == 0){
+            boot_n = atoi(argv[++i]);
+            if(boot_n < 1){
+                fprintf(stderr,"\nERROR: -bootstrap must be at least 1\n\n");
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr,"\t-bootstrap %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-block-size") == 0){
+            block_size = atoi(argv[++i]);
+            if(block_size < 1){
+                fprintf(stderr,"\nERROR: -block-size must be at least 1\n\n");
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr,"\t-block-size %s\n", argv[i]);
+        }
+        
+        else if(strcmp(argv[i], "-seed") == 0){
+            seed = strtoull(argv[++i], NULL, 10);
+            fprintf(stderr,"\t-seed %s\n", argv[i]);
+        }
+        
         else{
             fprintf(stderr,"\nERROR: Unknown argument '%s'\n\n", argv[i]);
             exit(EXIT_FAILURE);
@@ -157,393 +331,182 @@ void openFiles(int argc, char *argv[]){
     
     fprintf(stderr,"\n");
     
-    if(coord_file == NULL || div_file == NULL || site_file == NULL || vcf_file == NULL){
-        fprintf(stderr,"ERROR: The following parameters are required: -coord [file] -div [file] -sites [file] -vcf [file]\n\n");
+    if(coord_file == NULL || div_file == NULL || site_file == NULL || (vcf_file == NULL && add_file == NULL)){
+        fprintf(stderr,"ERROR: The following parameters are required: -coord [file] -div [file] -sites [file] -vcf [file] (or -add-counts [file])\n\n");
         exit(EXIT_FAILURE);
     }
     
-    coords = readCoord(coord_file, &coord_n);
-    if(target_file != NULL)
-        target = readTarget(target_file, &target_n);
-    sites = readSites(site_file, coords, target, coord_n, target_n, &site_n);
-    div = readDiv(div_file, sites, site_n, &div_n);
-    readVcf(vcf_file, sites, div, gc, site_n, div_n);
-}
-
-Region_s *readCoord(FILE *coord_file, int *n){
-    
-    int i, line_i=0;
-    char c, *line=NULL, *temp=NULL;
-    Region_s *list;
-    size_t len=0;
-    ssize_t read;
-    
-    while((c=fgetc(coord_file)) != EOF){
-        if(c == '\n')
-            line_i++;
+    if(gene_file != NULL && boot_n > 0){
+        fprintf(stderr,"ERROR: -bootstrap cannot be combined with -genes\n\n");
+        exit(EXIT_FAILURE);
     }
     
-    rewind(coord_file);
-    
-    if((list = malloc(line_i*sizeof(Region_s))) == NULL){
-        fprintf(stderr,merror);
+    if(win_size > 0 && (gene_file != NULL || boot_n > 0)){
+        fprintf(stderr,"ERROR: -window cannot be combined with -genes or -bootstrap\n\n");
         exit(EXIT_FAILURE);
     }
     
-    while((read = getline(&line, &len, coord_file)) != -1){
-        lineTerminator(line);
-        list[*n].start = atoi(strtok(line,"\t"));
-        list[*n].stop = atoi(strtok(NULL,"\t"));
-        for(i=0;i<6;i++)
-            temp = strtok(NULL,"\t");
-        if(isdigit(temp[0])){
-            list[*n].chr = atoi(temp);
-            *n = *n + 1;
-        }
+    if(project > 0 && (gene_file != NULL || win_size > 0)){
+        fprintf(stderr,"ERROR: -project cannot be combined with -genes or -window\n\n");
+        exit(EXIT_FAILURE);
     }
     
-    free(line);
-    fclose(coord_file);
-    
-    return list;
-}
-
-Region_s *readTarget(FILE *target_file, int *n){
-    
-    int i, line_i=0;
-    char c, *line=NULL;
-    Region_s *list;
-    size_t len=0;
-    ssize_t read;
-    
-    while((c=fgetc(target_file)) != EOF){
-        if(c == '\n')
-            line_i++;
+    if(win_step > 0 && win_size == 0){
+        fprintf(stderr,"ERROR: -step requires -window [int]\n\n");
+        exit(EXIT_FAILURE);
     }
     
-    rewind(target_file);
+    if(win_step == 0)
+        win_step = win_size;
     
-    if((list = malloc(line_i*sizeof(Region_s))) == NULL){
-        fprintf(stderr,merror);
+    if(pop_file != NULL && prefix == NULL){
+        fprintf(stderr,"ERROR: -pops requires -out [prefix]\n\n");
         exit(EXIT_FAILURE);
     }
     
-    while((read = getline(&line, &len, target_file)) != -1){
-        lineTerminator(line);
-        list[*n].chr = atoi(strtok(line,"\t"));
-        list[*n].start = atoi(strtok(NULL,"\t"));
-        list[*n].stop = atoi(strtok(NULL,"\t"));
-        *n = *n + 1;
+    if(pop_file != NULL){
+        pops = readPops(pop_file);
+        grp_n = pops->n;
+        statsPhase(&stats, "pops");
     }
     
-    free(line);
-    fclose(target_file);
-    
-    return list;
-}
-
-int **readSites(FILE *site_file, Region_s *coords, Region_s *target, int coord_n, int target_n, int *n){
-    
-    int i, j, line_i=0, brk=0, coord_i=0, target_i=0, **list;
-    char c, *line=NULL;
-    size_t len=0;
-    ssize_t read;
-    
-    while((c=fgetc(site_file)) != EOF){
-        if(c == '\n')
-            line_i++;
+    if((out = calloc(grp_n*gc_n, sizeof(FILE *))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
     }
     
-    rewind(site_file);
-    
-    if((list = malloc(line_i*sizeof(int*))) == NULL){
-        fprintf(stderr,merror);
+    if(gc == -1 && prefix == NULL){
+        fprintf(stderr,"ERROR: -gc all requires -out [prefix]\n\n");
         exit(EXIT_FAILURE);
     }
     
-    for(i=0;i<line_i;i++){
-        if((list[i] = malloc(2*sizeof(int))) == NULL){
+    if(gc == -1 || pops != NULL){
+        if((name = malloc(strlen(prefix)+70)) == NULL){
             fprintf(stderr,merror);
             exit(EXIT_FAILURE);
         }
-    }
-    
-    while((read = getline(&line, &len, site_file)) != -1){
-        lineTerminator(line);
-        if(isdigit(line[0]) == 0)
-            continue;
-        list[*n][0] = atoi(strtok(line,"\t"));
-        list[*n][1] = atoi(strtok(NULL,"\t"));
-        while(coord_i < coord_n){
-            if(list[*n][0] == coords[coord_i].chr){
-                if(list[*n][1] >= coords[coord_i].start && list[*n][1] <= coords[coord_i].stop){
-                    if(target_n > 0){
-                        brk = 0;
-                        while(target_i < target_n){
-                            if(list[*n][0] == target[target_i].chr){
-                                if(list[*n][1] >= target[target_i].start && list[*n][1] <= target[target_i].stop){
-                                    *n = *n + 1;
-                                    brk = 1;
-                                    break;
-                                }
-                                else if(list[*n][1] < target[target_i].start)
-                                    break;
-                            }
-                            else if(list[*n][0] < target[target_i].chr)
-                                break;
-                            target_i++;
-                        }
-                        if(brk == 1)
-                            break;
-                    }
-                    else{
-                        *n = *n + 1;
-                        break;
-                    }
+        for(g=0;g<grp_n;g++){
+            for(i=0;i<gc_n;i++){
+                if(gc != -1 && i != gc)
+                    continue;
+                if(pops != NULL)
+                    sprintf(name, "%s.%s.%s.txt", prefix, pops->groups[g].id, gc_names[i]);
+                else
+                    sprintf(name, "%s.%s.txt", prefix, gc_names[i]);
+                if((out[g*gc_n+i] = fopen(name, "w")) == NULL){
+                    fprintf(stderr,"ERROR: Cannot open file %s\n\n", name);
+                    exit(EXIT_FAILURE);
                 }
-                else if(list[*n][1] < coords[coord_i].start)
-                    break;
             }
-            else if(list[*n][0] < coords[coord_i].chr)
-                break;
-            coord_i++;
         }
+        free(name);
     }
-    
-    free(coords);
-    free(line);
-    fclose(site_file);
-    
-    return list;
-}
-
-Site_s *readDiv(FILE *div_file, int **sites, int site_n, int *n){
-    
-    int i, line_i=0, site_i=0;
-    char c, *line=NULL, *temp=NULL;
-    Site_s *list;
-    size_t len=0;
-    ssize_t read;
-    
-    while((c=fgetc(div_file)) != EOF){
-        if(c == '\n')
-            line_i++;
+    else
+        out[gc] = stdout;
+    
+    if(vcf_file != NULL)
+        src = sourceOpen(vcf_file, vcf_name);
+    statsPhase(&stats, "setup");
+    coords = readCoord(coord_file);
+    keysIndex(coords);
+    statsPhase(&stats, "coord");
+    if(target_file != NULL){
+        target = readTarget(target_file);
+        keysIndex(target);
+        statsPhase(&stats, "region");
     }
-    
-    rewind(div_file);
-    
-    if((list = malloc(line_i*sizeof(Site_s))) == NULL){
-        fprintf(stderr,merror);
-        exit(EXIT_FAILURE);
+    if(gene_file != NULL){
+        gene_keys = keysInit(0, 0);
+        genes = readGenes(gene_file, gene_keys);
+        keysIndex(gene_keys);
+        statsPhase(&stats, "genes");
     }
-    
-    while((read = getline(&line, &len, div_file)) != -1){
-        lineTerminator(line);
-        list[*n].pos = atoi(strtok(line,"\t"));
-        temp = strtok(NULL,"\t");
-        list[*n].ref = temp[0];
-        temp = strtok(NULL,"\t");
-        list[*n].alt = temp[0];
-        for(i=0;i<6;i++)
-            temp = strtok(NULL,"\t");
-        if(isdigit(temp[0])){
-            list[*n].chr = atoi(temp);
-            while(site_i < site_n){
-                if(list[*n].chr == sites[site_i][0]){
-                    if(list[*n].pos == sites[site_i][1]){
-                        *n = *n + 1;
-                        break;
-                    }
-                    else if(list[*n].pos < sites[site_i][1])
-                        break;
-                }
-                else if(list[*n].chr < sites[site_i][0])
-                    break;
-                site_i++;
+    sites = readSites(site_file, coords, target, gene_keys);
+    if(target != NULL)
+        keysFree(target);
+    statsPhase(&stats, "sites");
+    if(add_file != NULL || save_name != NULL){
+        if(add_file != NULL)
+            tally = tallyRead(add_file);
+        if(src != NULL){
+            batch = sourceTally(src, pops, coords, ploidy, threads, parsers, &stats);
+            sourceClose(src);
+            if(tally == NULL)
+                tally = batch;
+            else{
+                tallyMerge(tally, batch);
+                tallyFree(batch);
             }
         }
-    }
-    
-    free(line);
-    fclose(div_file);
-    
-    return list;
-}
-
-void readVcf(FILE *vcf_file, int **sites, Site_s *div, int gc, int site_n, int div_n){
-    
-    int i, j, chr=0, pos=0, i0=0, i1=0, count=0, ind_i=0, site_i=0, div_i=0, ok=0, rd=0, *geno;
-    double di=0, si=0, *sfs;
-    char ref, alt, *line=NULL, *temp=NULL;
-    size_t len=0;
-    ssize_t read;
-    
-    while((read = getline(&line, &len, vcf_file)) != -1){
-        lineTerminator(line);
-        
-        temp = strtok(line,"\t");
-        
-        if(strcmp(temp, "#CHROM") == 0){
-            i = 1;
-            while(temp != NULL){
-                if(i > 9)
-                    ind_i++;
-                temp = strtok(NULL,"\t");
-                i++;
-            }
-            
-            if((geno=malloc(ind_i*sizeof(int))) == NULL){
-                fprintf(stderr,merror);
+        if(save_name != NULL){
+            if((save_file = fopen(save_name, "w")) == NULL){
+                fprintf(stderr,"\nERROR: Cannot open file %s\n\n", save_name);
                 exit(EXIT_FAILURE);
             }
-            
-            if((sfs=malloc((ind_i+1)*sizeof(double))) == NULL){
-                fprintf(stderr,merror);
-                exit(EXIT_FAILURE);
-            }
-            
-            for(i=0;i<=ind_i;i++)
-                sfs[i] = 0;
-        }
-        else if(isdigit(temp[0])){
-            chr = atoi(temp);
-            i = 0;
-            j = 1;
-            i1 = 0;
-            i0 = 0;
-            ok = 0;
-            rd = 0;
-            while(temp != NULL){
-                if(j == 2){
-                    pos =  atoi(temp);
-                    while(site_i < site_n){
-                        if(chr == sites[site_i][0]){
-                            if(pos == sites[site_i][1]){
-                                while(div_i < div_n){
-                                    if(chr == div[div_i].chr){
-                                        if(pos == div[div_i].pos){
-                                            rd = 1;
-                                            break;
-                                        }
-                                        else if(pos < div[div_i].pos)
-                                            break;
-                                    }
-                                    else if(chr < div[div_i].chr)
-                                        break;
-                                    div_i++;
-                                }
-                                ok = 1;
-                                break;
-                            }
-                            else if(pos < sites[site_i][1])
-                                break;
-                        }
-                        else if(chr < sites[site_i][0])
-                            break;
-                        site_i++;
-                    }
-                    if(ok == 0)
-                        break;
-                }
-                else if(j == 4){
-                    ref = temp[0];
-                    if(rd == 1 && ref != div[div_i].ref){
-                        fprintf(stderr,"Warning: ref alleles differ at chr %i pos %i\n", chr, pos);
-                        ok = 0;
-                        break;
-                    }
-                }
-                else if(j == 5){
-                    alt = temp[0];
-                    if(gc != 0){
-                        ok = 0;
-                        if(rd == 1 && alt != div[div_i].alt)
-                            break;
-                        if(ref == '.' && alt == '.')
-                            break;
-                        if(gc == 3){
-                            if((ref == 'G' || ref == 'C' || ref == '.') && (alt == 'G' || alt == 'C' || alt == '.'))
-                                ok = 1;
-                        }
-                        else if(gc == 4){
-                            if((ref == 'A' || ref == 'T' || ref == '.') && (alt == 'A' || alt == 'T' || alt == '.'))
-                                ok = 1;
-                        }
-                        else if(gc == 5){
-                            if((ref == 'G' || ref == 'C' || ref == '.') && (alt == 'G' || alt == 'C' || alt == '.'))
-                                ok = 1;
-                            else if((ref == 'A' || ref == 'T' || ref == '.') && (alt == 'A' || alt == 'T' || alt == '.'))
-                                ok = 1;
-                        }
-                        else if(rd == 0){
-                            if(gc == 1 && (ref == 'A' || ref == 'T' || ref == '.') && (alt == 'G' || alt == 'C' || alt == '.'))
-                                ok = 1;
-                            else if(gc == 2 && (ref == 'G' || ref == 'C' || ref == '.') && (alt == 'A' || alt == 'T' || alt == '.'))
-                                ok = 1;
-                        }
-                        else if(rd == 1){
-                            if(gc == 1 && (ref == 'G' || ref == 'C' || ref == '.') && (alt == 'A' || alt == 'T' || alt == '.'))
-                                ok = 1;
-                            else if(gc == 2 && (ref == 'A' || ref == 'T' || ref == '.') && (alt == 'G' || alt == 'C' || alt == '.'))
-                                ok = 1;
-                        }
-                        if(ok == 0)
-                            break;
-                    }
-                }
-                else if(j > 9){
-                    if(temp[0] == '1' && temp[2] == '1'){
-                        geno[i] = 1;
-                        i1++;
-                    }
-                    else if(temp[0] == '0' && temp[2] == '0'){
-                        geno[i] = 0;
-                        i0++;
-                    }
-                    else
-                        geno[i] = 9;
-                    i++;
-                }
-                temp = strtok(NULL,"\t");
-                j++;
-            }
-            if(ok == 0)
-                continue;
-            for(i=0;i<ind_i;i++){
-                if(rd == 0 && geno[i] == 1)
-                    count++;
-                else if(rd == 0 && geno[i] == 9 && i1 > i0)
-                    count++;
-                else if(rd == 1 && geno[i] == 0)
-                    count++;
-                else if(rd == 1 && geno[i] == 9 && i0 > i1)
-                    count++;
-            }
-            sfs[count]++;
-            count = 0;
-            if(rd == 1)
-                di++;
-            si++;
+            tallyWrite(tally, save_file);
+            fclose(save_file);
         }
+        src = sourceCounts(tally);
+        statsPhase(&stats, "counts");
+    }
+    keysFree(coords);
+    div_keys = keysInit(1, 0);
+    div = readDiv(div_file, sites, div_keys);
+    statsPhase(&stats, "div");
+    if(dense_on == 1){
+        dense = denseInit(NULL, div_keys, div);
+        keysFree(div_keys);
+        free(div);
+        div_keys = NULL;
+        div = NULL;
+        statsPhase(&stats, "dense");
     }
     
-    for(i=0;i<=ind_i;i++)
-        printf("%.0f ", sfs[i]);
-    printf("\n");
-    printf("%.0f %.0f\n", si, di);
+    for(i=0;i<gc_n;i++){
+        if(out[i] != NULL)
+            use |= 1 << i;
+    }
     
-    free(line);
-    free(sfs);
-    free(geno);
-    fclose(vcf_file);
-}
-
-void lineTerminator(char *line){
+    sfs = sfsScan(src, pops, sites, div_keys, div, dense, genes, gene_keys, use, threads, parsers, ploidy, project, boot_n > 0 ? block_size : 0, win_size, win_step, &stats);
+    statsPhase(&stats, "vcf");
+    if(boot_n > 0){
+        sfsBoot(sfs, boot_n, seed, threads);
+        statsPhase(&stats, "bootstrap");
+    }
+    sfsWrite(sfs, out);
+    sfsFree(sfs);
+    sourceClose(src);
+    if(tally != NULL)
+        tallyFree(tally);
+    
+    keysFree(sites);
+    if(dense != NULL)
+        denseFree(dense);
+    else{
+        keysFree(div_keys);
+        free(div);
+    }
+    if(gene_keys != NULL){
+        keysFree(gene_keys);
+        free(genes);
+    }
+    
+    if(pops != NULL)
+        popsFree(pops);
+    
+    for(i=0;i<grp_n*gc_n;i++){
+        if(out[i] != NULL && out[i] != stdout)
+            fclose(out[i]);
+    }
+    free(out);
     
-    int i;
+    statsWarn(&stats, mis_file);
+    if(mis_file != NULL)
+        fclose(mis_file);
     
-    for(i=0;line[i]!=0;i++){
-        if(line[i] == '\n' || line[i] == '\r')
-            line[i] = '\0';
+    if(stats_file != NULL){
+        statsPhase(&stats, "output");
+        statsWrite(&stats, stats_file);
+        fclose(stats_file);
     }
 }
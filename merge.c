@@ -0,0 +1,235 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Packed (chromosome, position) keys and merge cursors for sorted sites and regions
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "merge.h"
+#define merror "\nERROR: System out of memory\n"
+#define sort_min 1048576
+#define sort_threads 8
+
+typedef struct{
+    uint64_t *key, *key_out;
+    int *idx, *idx_out, lo, hi, shift, count[256];
+}Sort_s;
+
+static void *countDigits(void *arg);
+static void *moveDigits(void *arg);
+static void runSort(Sort_s *parts, int part_n, void *(*run)(void *arg));
+
+Keys_s *keysInit(int points, int max){
+    
+    Keys_s *keys;
+    
+    if((keys = calloc(1, sizeof(Keys_s))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    keys->points = points;
+    
+    if(max > 0){
+        keys->max = max;
+        if((keys->stop = malloc(max*sizeof(uint64_t))) == NULL || (points == 0 && (keys->start = malloc(max*sizeof(uint64_t))) == NULL)){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+        if(points)
+            keys->start = keys->stop;
+    }
+    
+    return keys;
+}
+
+void keysAdd(Keys_s *keys, int chr, int start, int stop){
+    
+    if(keys->n == keys->max){
+        keys->max = keys->max == 0 ? 1024 : keys->max * 2;
+        if((keys->stop = realloc(keys->stop, keys->max*sizeof(uint64_t))) == NULL){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+        if(keys->points)
+            keys->start = keys->stop;
+        else if((keys->start = realloc(keys->start, keys->max*sizeof(uint64_t))) == NULL){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+    keys->start[keys->n] = makeKey(chr, start);
+    keys->stop[keys->n] = makeKey(chr, stop);
+    keys->n++;
+}
+
+void keysIndex(Keys_s *keys){
+    
+    int i;
+    
+    if((keys->maxstop = malloc((keys->n+1)*sizeof(uint64_t))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    for(i=0;i<keys->n;i++)
+        keys->maxstop[i] = i > 0 && keys->maxstop[i-1] > keys->stop[i] ? keys->maxstop[i-1] : keys->stop[i];
+}
+
+void keysFree(Keys_s *keys){
+    
+    if(keys->points == 0)
+        free(keys->start);
+    free(keys->stop);
+    free(keys->maxstop);
+    free(keys);
+}
+
+int keysSort(Keys_s *keys, void *data, size_t size){
+    
+    int i, j, d, t, part_n=1, n=keys->n, *idx, *idx_tmp, *swap_i;
+    long cpus;
+    uint64_t diff=0, *key, *key_tmp, *stop, *swap_k;
+    unsigned char *copy;
+    Sort_s parts[sort_threads];
+    
+    for(i=1;i<n && keys->start[i] >= keys->start[i-1];i++);
+    if(i >= n)
+        return 0;
+    
+    if((key = malloc(n*sizeof(uint64_t))) == NULL || (key_tmp = malloc(n*sizeof(uint64_t))) == NULL || (idx = malloc(n*sizeof(int))) == NULL || (idx_tmp = malloc(n*sizeof(int))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    for(i=0;i<n;i++){
+        key[i] = keys->start[i];
+        idx[i] = i;
+        diff |= key[i] ^ key[0];
+    }
+    
+    if(n >= sort_min && (cpus = sysconf(_SC_NPROCESSORS_ONLN)) > 1)
+        part_n = cpus < sort_threads ? cpus : sort_threads;
+    
+    for(d=0;d<64;d+=8){
+        if(((diff >> d) & 255) == 0)
+            continue;
+        for(t=0;t<part_n;t++){
+            parts[t].key = key;
+            parts[t].key_out = key_tmp;
+            parts[t].idx = idx;
+            parts[t].idx_out = idx_tmp;
+            parts[t].lo = (int64_t)n * t / part_n;
+            parts[t].hi = (int64_t)n * (t + 1) / part_n;
+            parts[t].shift = d;
+        }
+        runSort(parts, part_n, countDigits);
+        for(j=0,i=0;j<256;j++){
+            for(t=0;t<part_n;t++){
+                i += parts[t].count[j];
+                parts[t].count[j] = i - parts[t].count[j];
+            }
+        }
+        runSort(parts, part_n, moveDigits);
+        swap_k = key;
+        key = key_tmp;
+        key_tmp = swap_k;
+        swap_i = idx;
+        idx = idx_tmp;
+        idx_tmp = swap_i;
+    }
+    
+    if(keys->points == 0){
+        stop = key_tmp;
+        for(i=0;i<n;i++)
+            stop[i] = keys->stop[idx[i]];
+        memcpy(keys->stop, stop, n*sizeof(uint64_t));
+    }
+    memcpy(keys->start, key, n*sizeof(uint64_t));
+    
+    if(data != NULL){
+        if((copy = malloc(n*size)) == NULL){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+        for(i=0;i<n;i++)
+            memcpy(copy + (size_t)i*size, (unsigned char *)data + (size_t)idx[i]*size, size);
+        memcpy(data, copy, n*size);
+        free(copy);
+    }
+    
+    if(keys->maxstop != NULL){
+        free(keys->maxstop);
+        keysIndex(keys);
+    }
+    
+    free(key);
+    free(key_tmp);
+    free(idx);
+    free(idx_tmp);
+    
+    return 1;
+}
+
+static void *countDigits(void *arg){
+    
+    int i;
+    Sort_s *part = arg;
+    
+    memset(part->count, 0, sizeof(part->count));
+    for(i=part->lo;i<part->hi;i++)
+        part->count[(part->key[i] >> part->shift) & 255]++;
+    
+    return NULL;
+}
+
+static void *moveDigits(void *arg){
+    
+    int i, j;
+    Sort_s *part = arg;
+    
+    for(i=part->lo;i<part->hi;i++){
+        j = part->count[(part->key[i] >> part->shift) & 255]++;
+        part->key_out[j] = part->key[i];
+        part->idx_out[j] = part->idx[i];
+    }
+    
+    return NULL;
+}
+
+static void runSort(Sort_s *parts, int part_n, void *(*run)(void *arg)){
+    
+    int t;
+    pthread_t tid[sort_threads];
+    
+    for(t=1;t<part_n;t++){
+        if(pthread_create(&tid[t], NULL, run, &parts[t]) != 0){
+            fprintf(stderr,"\nERROR: Cannot create thread\n\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+    run(&parts[0]);
+    
+    for(t=1;t<part_n;t++)
+        pthread_join(tid[t], NULL);
+}
@@ -0,0 +1,118 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Packed (chromosome, position) keys and merge cursors for sorted sites and regions
+ 
+ A key stores the chromosome in the upper and the position in the lower 32 bits, so sorted keys order by chromosome and then position. Point lists (sites) share the start and stop arrays.
+ 
+ keysSort checks that the keys are sorted by start and otherwise sorts them in memory, together with the size-byte records of data (NULL for none), with a radix sort over the bytes of the keys that differ, split over the processors for large lists. The sort is stable, so keys with the same start keep the order of the file. It returns 1 when the keys were out of order.
+ 
+ keySearch and keySearchUpper find by bisection the index that keySeek and keyUpper reach from 0, for cursors that start in the middle of the keys or go back (keySearch uses the running maximum of keysIndex when there is one, so it also holds for overlapping intervals).
+ 
+ keySeek and keyHit assume intervals that do not overlap. For overlapping intervals sorted by start, keysIndex adds the running maximum of the stops, and keyOverlaps then walks back from keyUpper only as far as an interval can still reach the key.
+ */
+
+
+#ifndef MERGE_H
+#define MERGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define makeKey(chr, pos) ((uint64_t)(uint32_t)(chr) << 32 | (uint32_t)(pos))
+#define keyChr(key) ((int)((key) >> 32))
+#define keyPos(key) ((int)((key) & 0xffffffff))
+
+typedef struct{
+    uint64_t *start, *stop, *maxstop;
+    int n, max, points;
+}Keys_s;
+
+Keys_s *keysInit(int points, int max);
+void keysAdd(Keys_s *keys, int chr, int start, int stop);
+void keysIndex(Keys_s *keys);
+int keysSort(Keys_s *keys, void *data, size_t size);
+void keysFree(Keys_s *keys);
+
+static inline int keySeek(const Keys_s *keys, int i, uint64_t key){
+    
+    while(i < keys->n && keys->stop[i] < key)
+        i++;
+    
+    return i;
+}
+
+static inline int keyHit(const Keys_s *keys, int i, uint64_t key){
+    
+    return i < keys->n && keys->start[i] <= key;
+}
+
+static inline int keyUpper(const Keys_s *keys, int i, uint64_t key){
+    
+    while(i < keys->n && keys->start[i] <= key)
+        i++;
+    
+    return i;
+}
+
+static inline int keySearch(const Keys_s *keys, uint64_t key){
+    
+    int lo=0, hi=keys->n, mid;
+    const uint64_t *stop = keys->maxstop != NULL ? keys->maxstop : keys->stop;
+    
+    while(lo < hi){
+        mid = lo + (hi - lo) / 2;
+        if(stop[mid] < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    
+    return lo;
+}
+
+static inline int keySearchUpper(const Keys_s *keys, uint64_t key){
+    
+    int lo=0, hi=keys->n, mid;
+    
+    while(lo < hi){
+        mid = lo + (hi - lo) / 2;
+        if(keys->start[mid] <= key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    
+    return lo;
+}
+
+static inline int keyOverlaps(const Keys_s *keys, int hi, uint64_t key, int *hits){
+    
+    int i, n=0;
+    
+    for(i=hi-1;i>=0 && keys->maxstop[i] >= key;i--){
+        if(keys->stop[i] >= key){
+            if(hits == NULL)
+                return 1;
+            hits[n++] = i;
+        }
+    }
+    
+    return n;
+}
+
+#endif
@@ -0,0 +1,424 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Readers for the MUMmer alignments and their binary caches
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "mummer.h"
+#include "input.h"
+#include "contig.h"
+#define merror "\nERROR: System out of memory\n"
+#define aln_coord 1
+#define aln_div 2
+
+static const char aln_magic[4] = {'M', 'U', 'M', 1};
+
+static uint64_t checkSum(const unsigned char *data, size_t size){
+    
+    size_t i;
+    uint64_t h=0xcbf29ce484222325ULL, w;
+    
+    for(i=0;i+8<=size;i+=8){
+        memcpy(&w, data + i, 8);
+        h = (h ^ w) * 0x100000001b3ULL;
+        h ^= h >> 29;
+    }
+    for(;i<size;i++)
+        h = (h ^ data[i]) * 0x100000001b3ULL;
+    
+    return h;
+}
+
+static unsigned char *mapCache(FILE *fp, int type, size_t width, AlnHead_s **head, size_t *size){
+    
+    struct stat st;
+    unsigned char *data;
+    
+    if(fstat(fileno(fp), &st) != 0 || S_ISREG(st.st_mode) == 0 || st.st_size < (off_t)sizeof(AlnHead_s))
+        return NULL;
+    
+    if((data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(fp), 0)) == MAP_FAILED)
+        return NULL;
+    
+    *head = (AlnHead_s *)data;
+    *size = st.st_size;
+    
+    if(memcmp((*head)->magic, aln_magic, 3) != 0){
+        munmap(data, *size);
+        return NULL;
+    }
+    
+    if((*head)->magic[3] != aln_magic[3]){
+        fprintf(stderr,"\nERROR: The alignment cache was made with another version of makeCache\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    if((*head)->type != type){
+        fprintf(stderr,"\nERROR: The alignment cache holds %s, not %s\n\n", (*head)->type == aln_coord ? "coordinates" : "substitutions", type == aln_coord ? "coordinates" : "substitutions");
+        exit(EXIT_FAILURE);
+    }
+    
+    if((*head)->n < 0 || sizeof(AlnHead_s) + (size_t)(*head)->n * width > *size || checkSum(data + sizeof(AlnHead_s), *size - sizeof(AlnHead_s)) != (*head)->sum){
+        fprintf(stderr,"\nERROR: The alignment cache is truncated or corrupted\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    return data;
+}
+
+static uint64_t mapKey(const int *map, int n, uint64_t key){
+    
+    int chr=keyChr(key);
+    
+    if(map == NULL || chr < contig_base)
+        return key;
+    
+    if(chr - contig_base >= n){
+        fprintf(stderr,"\nERROR: The alignment cache is truncated or corrupted\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    return makeKey(map[chr-contig_base], keyPos(key));
+}
+
+static void writeCache(FILE *out, int type, int64_t n, const void **parts, const size_t *sizes, int part_n){
+    
+    int i;
+    size_t total=0;
+    unsigned char *data;
+    AlnHead_s head;
+    
+    for(i=0;i<part_n;i++)
+        total += sizes[i];
+    
+    if((data = malloc(total+1)) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    for(i=0,total=0;i<part_n;i++){
+        if(sizes[i] > 0)
+            memcpy(data + total, parts[i], sizes[i]);
+        total += sizes[i];
+    }
+    
+    memset(&head, 0, sizeof(AlnHead_s));
+    memcpy(head.magic, aln_magic, 4);
+    head.type = type;
+    head.n = n;
+    head.sum = checkSum(data, total);
+    
+    fwrite(&head, sizeof(AlnHead_s), 1, out);
+    fwrite(data, 1, total, out);
+    
+    if(ferror(out)){
+        fprintf(stderr,"\nERROR: Cannot write the alignment cache\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    free(data);
+}
+
+Keys_s *readCoord(FILE *coord_file){
+    
+    int i, start, stop, chr, name_n, *names;
+    char *p, *eol, *temp;
+    Contig_s last={0};
+    size_t size;
+    unsigned char *data;
+    AlnHead_s *head;
+    Keys_s *list;
+    Map_s *map;
+    
+    if((data = mapCache(coord_file, aln_coord, 2*sizeof(uint64_t), &head, &size)) != NULL){
+        list = keysInit(0, head->n + 1);
+        memcpy(list->start, data + sizeof(AlnHead_s), head->n*sizeof(uint64_t));
+        memcpy(list->stop, data + sizeof(AlnHead_s) + head->n*sizeof(uint64_t), head->n*sizeof(uint64_t));
+        list->n = head->n;
+        if((names = contigMap((const char *)data + sizeof(AlnHead_s) + head->n*2*sizeof(uint64_t), size - sizeof(AlnHead_s) - head->n*2*sizeof(uint64_t), &name_n)) != NULL){
+            for(i=0;i<list->n;i++){
+                list->start[i] = mapKey(names, name_n, list->start[i]);
+                list->stop[i] = mapKey(names, name_n, list->stop[i]);
+            }
+            free(names);
+        }
+        munmap(data, size);
+        fclose(coord_file);
+        keysSort(list, NULL, 0);
+        return list;
+    }
+    
+    map = mapFile(coord_file);
+    list = keysInit(0, 0);
+    
+    while(mapLine(map, &p, &eol)){
+        start = atoi(p);
+        temp = nextField(p, eol);
+        stop = atoi(temp);
+        for(i=0;i<6;i++)
+            temp = nextField(temp, eol);
+        if(isdigit(p[0]) && (chr = contigField(&last, temp, eol)) >= 0)
+            keysAdd(list, chr, start, stop);
+    }
+    
+    unmapFile(map);
+    fclose(coord_file);
+    keysSort(list, NULL, 0);
+    
+    return list;
+}
+
+Site_s *readDiv(FILE *div_file, Keys_s *sites, Keys_s *keys){
+    
+    int i, chr, pos, max=0, site_i=0, name_n, *names;
+    int64_t j;
+    char *p, *eol, *temp, ref, alt;
+    Contig_s last={0};
+    size_t size;
+    uint64_t key, prev=0, *cache_keys;
+    unsigned char *data;
+    AlnHead_s *head;
+    Site_s *list=NULL, *cache_div;
+    Map_s *map;
+    
+    if((data = mapCache(div_file, aln_div, sizeof(uint64_t)+sizeof(Site_s), &head, &size)) != NULL){
+        cache_keys = (uint64_t *)(data + sizeof(AlnHead_s));
+        cache_div = (Site_s *)(data + sizeof(AlnHead_s) + head->n*sizeof(uint64_t));
+        names = contigMap((const char *)(cache_div + head->n), size - sizeof(AlnHead_s) - head->n*(sizeof(uint64_t)+sizeof(Site_s)), &name_n);
+        for(j=0;j<head->n;j++){
+            key = mapKey(names, name_n, cache_keys[j]);
+            if(sites != NULL){
+                site_i = key < prev ? keySearch(sites, key) : keySeek(sites, site_i, key);
+                prev = key;
+                if(keyHit(sites, site_i, key) == 0)
+                    continue;
+            }
+            if(keys->n == max){
+                max = max == 0 ? 1024 : max * 2;
+                if((list = realloc(list, max*sizeof(Site_s))) == NULL){
+                    fprintf(stderr,merror);
+                    exit(EXIT_FAILURE);
+                }
+            }
+            list[keys->n] = cache_div[j];
+            keysAdd(keys, keyChr(key), keyPos(key), keyPos(key));
+        }
+        free(names);
+        munmap(data, size);
+        fclose(div_file);
+        keysSort(keys, list, sizeof(Site_s));
+        return list;
+    }
+    
+    map = mapFile(div_file);
+    
+    while(mapLine(map, &p, &eol)){
+        pos = atoi(p);
+        temp = nextField(p, eol);
+        ref = temp[0];
+        temp = nextField(temp, eol);
+        alt = temp[0];
+        for(i=0;i<6;i++)
+            temp = nextField(temp, eol);
+        if(isdigit(p[0]) == 0 || (chr = contigField(&last, temp, eol)) < 0)
+            continue;
+        key = makeKey(chr, pos);
+        if(sites != NULL){
+            site_i = key < prev ? keySearch(sites, key) : keySeek(sites, site_i, key);
+            prev = key;
+            if(keyHit(sites, site_i, key) == 0)
+                continue;
+        }
+        if(keys->n == max){
+            max = max == 0 ? 1024 : max * 2;
+            if((list = realloc(list, max*sizeof(Site_s))) == NULL){
+                fprintf(stderr,merror);
+                exit(EXIT_FAILURE);
+            }
+        }
+        list[keys->n].ref = ref;
+        list[keys->n].alt = alt;
+        keysAdd(keys, keyChr(key), pos, pos);
+    }
+    
+    unmapFile(map);
+    fclose(div_file);
+    keysSort(keys, list, sizeof(Site_s));
+    
+    return list;
+}
+
+void writeCoord(Keys_s *coords, FILE *out){
+    
+    void *block;
+    size_t size;
+    
+    contigBlock(&block, &size);
+    writeCache(out, aln_coord, coords->n, (const void *[3]){coords->start, coords->stop, block}, (size_t [3]){coords->n*sizeof(uint64_t), coords->n*sizeof(uint64_t), size}, 3);
+    free(block);
+}
+
+void writeDiv(Keys_s *keys, Site_s *div, FILE *out){
+    
+    void *block;
+    size_t size;
+    
+    contigBlock(&block, &size);
+    writeCache(out, aln_div, keys->n, (const void *[3]){keys->start, div, block}, (size_t [3]){keys->n*sizeof(uint64_t), keys->n*sizeof(Site_s), size}, 3);
+    free(block);
+}
+
+static void denseGrow(Dense_s *dense, int chr, int pos){
+    
+    if(chr < 0 || pos < 0){
+        fprintf(stderr,"\nERROR: Negative chromosome or position in the alignments\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    if(chr >= dense->chr_n){
+        if((dense->chrs = realloc(dense->chrs, (chr+1)*sizeof(DenseChr_s))) == NULL){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+        memset(&dense->chrs[dense->chr_n], 0, (chr+1-dense->chr_n)*sizeof(DenseChr_s));
+        dense->chr_n = chr + 1;
+    }
+    
+    if(pos >= dense->chrs[chr].len)
+        dense->chrs[chr].len = pos + 1;
+}
+
+static void denseBits(DenseChr_s *c, uint64_t **bits){
+    
+    if(*bits == NULL && (*bits = calloc((c->len >> 6) + 1, sizeof(uint64_t))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+}
+
+static int denseBase(char base){
+    
+    switch(base){
+        case 'A': return 0;
+        case 'C': return 1;
+        case 'G': return 2;
+        case 'T': return 3;
+    }
+    
+    return -1;
+}
+
+Dense_s *denseInit(Keys_s *coords, Keys_s *div_keys, Site_s *div){
+    
+    int i, w, chr, pos, stop, b1, b2;
+    char buf[contig_buf];
+    uint32_t r;
+    DenseChr_s *c;
+    Dense_s *dense;
+    
+    if((dense = calloc(1, sizeof(Dense_s))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    for(i=0;coords != NULL && i<coords->n;i++){
+        if(keyChr(coords->start[i]) < contig_base && keyChr(coords->start[i]) >= dense->numbered)
+            dense->numbered = keyChr(coords->start[i]) + 1;
+    }
+    for(i=0;div_keys != NULL && i<div_keys->n;i++){
+        if(keyChr(div_keys->start[i]) < contig_base && keyChr(div_keys->start[i]) >= dense->numbered)
+            dense->numbered = keyChr(div_keys->start[i]) + 1;
+    }
+    
+    for(i=0;coords != NULL && i<coords->n;i++)
+        denseGrow(dense, denseSlot(dense, keyChr(coords->start[i])), keyPos(coords->stop[i]));
+    for(i=0;div_keys != NULL && i<div_keys->n;i++)
+        denseGrow(dense, denseSlot(dense, keyChr(div_keys->start[i])), keyPos(div_keys->start[i]));
+    
+    for(i=0;coords != NULL && i<coords->n;i++){
+        c = &dense->chrs[denseSlot(dense, keyChr(coords->start[i]))];
+        denseBits(c, &c->aln);
+        for(pos=keyPos(coords->start[i]),stop=keyPos(coords->stop[i]);pos<=stop;pos++){
+            if((pos & 63) == 0 && pos + 63 <= stop){
+                c->aln[pos >> 6] = UINT64_MAX;
+                pos += 63;
+            }
+            else
+                c->aln[pos >> 6] |= 1ULL << (pos & 63);
+        }
+    }
+    
+    for(i=0;div_keys != NULL && i<div_keys->n;i++){
+        c = &dense->chrs[denseSlot(dense, keyChr(div_keys->start[i]))];
+        denseBits(c, &c->div);
+        pos = keyPos(div_keys->start[i]);
+        c->div[pos >> 6] |= 1ULL << (pos & 63);
+    }
+    
+    for(chr=0;chr<dense->chr_n;chr++){
+        c = &dense->chrs[chr];
+        if(c->div == NULL)
+            continue;
+        if((c->rank = malloc(((c->len >> 6) + 1)*sizeof(uint32_t))) == NULL){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+        for(w=0,r=0;w<=c->len>>6;w++){
+            c->rank[w] = r;
+            r += __builtin_popcountll(c->div[w]);
+        }
+        if((c->base = calloc(r / 2 + 1, 1)) == NULL){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+    for(i=0;div_keys != NULL && i<div_keys->n;i++){
+        c = &dense->chrs[denseSlot(dense, keyChr(div_keys->start[i]))];
+        pos = keyPos(div_keys->start[i]);
+        r = c->rank[pos >> 6] + __builtin_popcountll(c->div[pos >> 6] & ((1ULL << (pos & 63)) - 1));
+        if((b1 = denseBase(div[i].ref)) < 0 || (b2 = denseBase(div[i].alt)) < 0){
+            fprintf(stderr,"\nERROR: -dense needs substitutions between A, C, G and T, not %c->%c at %s:%i\n\n", div[i].ref, div[i].alt, contigName(keyChr(div_keys->start[i]), buf), pos);
+            exit(EXIT_FAILURE);
+        }
+        if(((c->base[r >> 1] >> ((r & 1) << 2)) & 15) == 0)
+            c->base[r >> 1] |= (b1 << 2 | b2) << ((r & 1) << 2);
+    }
+    
+    return dense;
+}
+
+void denseFree(Dense_s *dense){
+    
+    int i;
+    
+    for(i=0;i<dense->chr_n;i++){
+        free(dense->chrs[i].aln);
+        free(dense->chrs[i].div);
+        free(dense->chrs[i].rank);
+        free(dense->chrs[i].base);
+    }
+    
+    free(dense->chrs);
+    free(dense);
+}
@@ -0,0 +1,97 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Readers for the MUMmer alignments and their binary caches
+ 
+ readCoord and readDiv parse the output of show-coords (-H -T) and show-snps (-C -I -H -T), or a binary cache of either written by makeCache. The chromosome is the reference tag of each line, a number or a name. A cache holds the packed keys (and the ref and alt bases for snps) and the names of the named chromosomes behind a versioned header with a checksum of the data, and is memory-mapped and copied instead of parsed. Caches are recognised only in regular files.
+ 
+ denseInit packs the coordinates and substitutions into one Dense_s per chromosome: a bitmap of the aligned positions, a bitmap of the diverged positions with the count of set bits before each word, and the ref and alt bases of the diverged positions at 2 bits each in the order of the positions. denseAligned and denseDiv then look a key up in constant time and in any order. The numbered chromosomes take the first slots and the named ones (see contig.h) follow them. Either list can be NULL, and the bases have to be A, C, G or T.
+ */
+
+#ifndef MUMMER_H
+#define MUMMER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "merge.h"
+#include "contig.h"
+
+typedef struct{
+    char ref, alt;
+}Site_s;
+
+typedef struct{
+    int len;
+    uint64_t *aln, *div;
+    uint32_t *rank;
+    unsigned char *base;
+}DenseChr_s;
+
+typedef struct{
+    int chr_n, numbered;
+    DenseChr_s *chrs;
+}Dense_s;
+
+typedef struct{
+    char magic[4];
+    int type;
+    int64_t n;
+    uint64_t sum;
+}AlnHead_s;
+
+Keys_s *readCoord(FILE *coord_file);
+Site_s *readDiv(FILE *div_file, Keys_s *sites, Keys_s *keys);
+void writeCoord(Keys_s *coords, FILE *out);
+void writeDiv(Keys_s *keys, Site_s *div, FILE *out);
+Dense_s *denseInit(Keys_s *coords, Keys_s *div_keys, Site_s *div);
+void denseFree(Dense_s *dense);
+
+static inline int denseSlot(const Dense_s *dense, int chr){
+    
+    return chr < contig_base ? chr : dense->numbered + chr - contig_base;
+}
+
+static inline int denseAligned(const Dense_s *dense, uint64_t key){
+    
+    int chr=denseSlot(dense, keyChr(key)), pos=keyPos(key);
+    const DenseChr_s *c;
+    
+    if(chr >= dense->chr_n || (c = &dense->chrs[chr])->aln == NULL || pos >= c->len)
+        return 0;
+    
+    return (c->aln[pos >> 6] >> (pos & 63)) & 1;
+}
+
+static inline int denseDiv(const Dense_s *dense, uint64_t key, char *ref, char *alt){
+    
+    static const char bases[4] = {'A', 'C', 'G', 'T'};
+    int chr=denseSlot(dense, keyChr(key)), pos=keyPos(key), b;
+    uint32_t r;
+    const DenseChr_s *c;
+    
+    if(chr >= dense->chr_n || (c = &dense->chrs[chr])->div == NULL || pos >= c->len || ((c->div[pos >> 6] >> (pos & 63)) & 1) == 0)
+        return 0;
+    
+    r = c->rank[pos >> 6] + __builtin_popcountll(c->div[pos >> 6] & ((1ULL << (pos & 63)) - 1));
+    b = (c->base[r >> 1] >> ((r & 1) << 2)) & 15;
+    *ref = bases[b >> 2];
+    *alt = bases[b & 3];
+    
+    return 1;
+}
+
+#endif
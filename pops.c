@@ -0,0 +1,214 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Sample groups for computing the counts of several populations in one pass
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pops.h"
+#include "input.h"
+#define merror "\nERROR: System out of memory\n"
+
+Pops_s *readPops(FILE *pop_file){
+    
+    int i, max=0;
+    char *p, *eol, group[50];
+    Pops_s *pops;
+    Map_s *map;
+    
+    if((pops = calloc(1, sizeof(Pops_s))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    map = mapFile(pop_file);
+    
+    while(mapLine(map, &p, &eol)){
+        if(p == eol || *p == '#' || *p == '\r')
+            continue;
+        if(pops->member_n == max){
+            max = max == 0 ? 1024 : max * 2;
+            if((pops->members = realloc(pops->members, max*sizeof(Member_s))) == NULL || (pops->groups = realloc(pops->groups, max*sizeof(Group_s))) == NULL){
+                fprintf(stderr,merror);
+                exit(EXIT_FAILURE);
+            }
+        }
+        copyField(pops->members[pops->member_n].id, p, 99);
+        copyField(group, nextField(p, eol), 49);
+        if(group[0] == '\0'){
+            fprintf(stderr,"\nERROR: No group given for sample %s in the -pops file\n\n", pops->members[pops->member_n].id);
+            exit(EXIT_FAILURE);
+        }
+        for(i=0;i<pops->n && strcmp(pops->groups[i].id, group) != 0;i++);
+        if(i == pops->n){
+            memset(&pops->groups[i], 0, sizeof(Group_s));
+            strcpy(pops->groups[i].id, group);
+            pops->n++;
+        }
+        pops->members[pops->member_n].group = i;
+        pops->member_n++;
+    }
+    
+    unmapFile(map);
+    fclose(pop_file);
+    
+    if(pops->n == 0){
+        fprintf(stderr,"\nERROR: The -pops file contains no samples\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    return pops;
+}
+
+void popsIndex(Pops_s *pops, const char *header, int partial){
+    
+    int i, j, len, samples=0, *col, *next;
+    const char *p=header, *q;
+    
+    free(pops->ind);
+    free(pops->masks);
+    
+    for(i=0;i<pops->n;i++)
+        pops->groups[i].size = 0;
+    
+    for(i=0;i<9 && p != NULL;i++){
+        if((p = strchr(p, '\t')) != NULL)
+            p++;
+    }
+    
+    if((col = malloc(pops->member_n*sizeof(int))) == NULL || (next = calloc(pops->n+1, sizeof(int))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    for(i=0;i<pops->member_n;i++)
+        col[i] = -1;
+    
+    while(p != NULL && *p != '\0' && *p != '\n' && *p != '\r'){
+        for(q=p;*q != '\0' && *q != '\t' && *q != '\n' && *q != '\r';q++);
+        len = q - p;
+        for(i=0;i<pops->member_n;i++){
+            if(col[i] == -1 && (int)strlen(pops->members[i].id) == len && strncmp(pops->members[i].id, p, len) == 0)
+                col[i] = samples;
+        }
+        samples++;
+        p = *q == '\t' ? q + 1 : NULL;
+    }
+    
+    pops->words = (samples + 63) / 64;
+    
+    if((pops->ind = malloc((pops->member_n+1)*sizeof(int))) == NULL || (pops->masks = calloc((size_t)pops->n*pops->words+1, sizeof(uint64_t))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    for(i=0,j=0;i<pops->member_n;i++){
+        if(col[i] == -1 && partial == 0){
+            fprintf(stderr,"\nERROR: Sample %s in the -pops file is not in the vcf-file\n\n", pops->members[i].id);
+            exit(EXIT_FAILURE);
+        }
+        if(col[i] == -1)
+            continue;
+        pops->groups[pops->members[i].group].size++;
+        j++;
+    }
+    
+    if(j == 0){
+        fprintf(stderr,"\nERROR: None of the samples in the -pops file are in the vcf-file\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    for(i=0;i<pops->n;i++)
+        next[i+1] = next[i] + pops->groups[i].size;
+    
+    for(i=0;i<pops->n;i++){
+        pops->groups[i].ind = pops->ind + next[i];
+        pops->groups[i].mask = pops->masks + (size_t)i*pops->words;
+    }
+    
+    for(i=0;i<pops->member_n;i++){
+        if(col[i] == -1)
+            continue;
+        j = pops->members[i].group;
+        if(pops->groups[j].mask[col[i]>>6] & ((uint64_t)1 << (col[i] & 63))){
+            fprintf(stderr,"\nERROR: Sample %s is listed twice for group %s in the -pops file\n\n", pops->members[i].id, pops->groups[j].id);
+            exit(EXIT_FAILURE);
+        }
+        pops->ind[next[j]++] = col[i];
+        pops->groups[j].mask[col[i]>>6] |= (uint64_t)1 << (col[i] & 63);
+    }
+    
+    free(col);
+    free(next);
+}
+
+void popsCount(Group_s *group, unsigned char *a1, unsigned char *a2, int n, int *m, int *n00, int *n11, int *nmiss){
+    
+    int i, j, c=0, c00=0, c11=0, cm=0;
+    
+    for(i=0;i<group->size;i++){
+        j = group->ind[i];
+        if(j >= n)
+            continue;
+        c++;
+        if(a1[j] == '0' && a2[j] == '0')
+            c00++;
+        else if(a1[j] == '1' && a2[j] == '1')
+            c11++;
+        if(a1[j] == '.' || a2[j] == '.')
+            cm++;
+    }
+    
+    *m = c;
+    *n00 = c00;
+    *n11 = c11;
+    *nmiss = cm;
+}
+
+void popsDoseCount(Group_s *group, unsigned char *a1, unsigned char *a2, int n, int ploidy, int *m, int *n00, int *n11, int *nmiss){
+    
+    int i, j, c=0, r=0, a=0, cm=0;
+    
+    for(i=0;i<group->size;i++){
+        j = group->ind[i];
+        if(j >= n)
+            continue;
+        c++;
+        if(a1[j] == 255)
+            cm++;
+        else{
+            r += a1[j];
+            a += a2[j];
+        }
+    }
+    
+    *m = ploidy * c;
+    *n00 = r;
+    *n11 = a;
+    *nmiss = ploidy * cm;
+}
+
+void popsFree(Pops_s *pops){
+    
+    free(pops->ind);
+    free(pops->masks);
+    free(pops->groups);
+    free(pops->members);
+    free(pops);
+}
@@ -0,0 +1,53 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Sample groups for computing the counts of several populations in one pass
+ 
+ The -pops file has a sample name and a group name on each line. Groups keep the order in which they first appear, and a sample can belong to several groups. popsIndex matches the samples against the #CHROM line of the vcf-file and stores the genotype columns of each group as one contiguous index vector, plus a bit mask over the samples for reading genotype caches. It can be called again to match the same groups against another file. With partial, the samples missing from the file are left out of their groups instead of stopping the program, for a vcf-file that holds one batch of the samples.
+ */
+
+#ifndef POPS_H
+#define POPS_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+typedef struct{
+    char id[50];
+    int size, *ind;
+    uint64_t *mask;
+}Group_s;
+
+typedef struct{
+    char id[100];
+    int group;
+}Member_s;
+
+typedef struct{
+    int n, member_n, words, *ind;
+    Group_s *groups;
+    Member_s *members;
+    uint64_t *masks;
+}Pops_s;
+
+Pops_s *readPops(FILE *pop_file);
+void popsIndex(Pops_s *pops, const char *header, int partial);
+void popsCount(Group_s *group, unsigned char *a1, unsigned char *a2, int n, int *m, int *n00, int *n11, int *nmiss);
+void popsDoseCount(Group_s *group, unsigned char *a1, unsigned char *a2, int n, int ploidy, int *m, int *n00, int *n11, int *nmiss);
+void popsFree(Pops_s *pops);
+
+#endif
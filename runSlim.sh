@@ -0,0 +1,147 @@
+#!/bin/bash
+#
+# Version 2020.01.04
+#
+# Copyright (C) 2020 Tuomas Hamala
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# For any other inquiries send an email to tuomas.hamala@gmail.com
+#
+# Driver for running gBGC.slim over a grid of parameters
+#
+# usage:
+# -alpha [list] mutation rates to use, separated by spaces or commas (default 7e-9)
+# -selfing [list] selfing rates to use (default 0.95)
+# -bias [list] gene conversion biases to use (default 0.2)
+# -reps [int] number of replicates for each combination (default 1)
+# -seed [int] seed of the first run, the others get the following seeds (default 1)
+# -threads [int] number of runs in parallel (default 1)
+# -burnin [int] generation at which the burn-in is saved, each combination of alpha, selfing and replicate then gets one burn-in that all the bias values continue from (optional)
+# -burnin-bias [float] gene conversion bias during the burn-in (default 0)
+# -states [dir] directory for the saved burn-ins (default a temporary directory that is removed at the end)
+# -slim [file] SLiM executable (default slim)
+# -script [file] SLiM script (default gBGC.slim in the directory of this driver)
+#
+# example:
+# ./runSlim.sh -alpha 7e-9,1e-8 -selfing 0.9,0.95,0.99 -bias 0,0.2 -reps 10 -threads 32 > gBGC.grid.txt
+# ./runSlim.sh -alpha 7e-9 -selfing 0.95 -bias 0,0.05,0.1,0.2,0.4 -reps 10 -burnin 1400000 -threads 32 > gBGC.bias.txt
+#
+# With -burnin, the burn-ins are run first and get the seeds from -seed on, and the runs continuing from them get the seeds after those.
+#
+# Writes a tab-delimited table with alpha, selfing, bias, replicate, seed, ws/sw and GC for each run to standard output, in the order of the grid whatever the order in which the runs finish.
+
+alpha="7e-9"
+selfing="0.95"
+bias="0.2"
+reps=1
+seed=1
+threads=1
+slim=slim
+burnin=0
+burnin_bias=0
+states=""
+script="$(dirname "$0")/gBGC.slim"
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+        -alpha) alpha="$2" ;;
+        -selfing) selfing="$2" ;;
+        -bias) bias="$2" ;;
+        -reps) reps="$2" ;;
+        -seed) seed="$2" ;;
+        -threads) threads="$2" ;;
+        -slim) slim="$2" ;;
+        -script) script="$2" ;;
+        -burnin) burnin="$2" ;;
+        -burnin-bias) burnin_bias="$2" ;;
+        -states) states="$2" ;;
+        *) echo -e "\nERROR: Unknown argument '$1'\n" >&2; exit 1 ;;
+    esac
+    shift 2
+done
+
+if ! [ "$reps" -ge 1 ] 2>/dev/null || ! [ "$threads" -ge 1 ] 2>/dev/null; then
+    echo -e "\nERROR: -reps and -threads must be at least 1\n" >&2
+    exit 1
+fi
+
+if ! [ "$burnin" -ge 0 ] 2>/dev/null; then
+    echo -e "\nERROR: -burnin must be a generation\n" >&2
+    exit 1
+fi
+
+if [ ! -f "$script" ]; then
+    echo -e "\nERROR: Cannot open file $script\n" >&2
+    exit 1
+fi
+
+runBurnin(){
+    if ! "$slim" -s "$5" -d "alpha=$2" -d "selfing=$3" -d "bias=$burnin_bias" -d "burnin=$burnin" -d "save='$states/burnin.$1.bin'" "$script" > /dev/null 2>&1 || [ ! -s "$states/burnin.$1.bin" ]; then
+        echo "Warning: burn-in $1 (alpha $2, selfing $3, seed $5) failed" >&2
+        rm -f "$states/burnin.$1.bin"
+    fi
+}
+
+runOne(){
+    local out="" load=()
+    if [ "$7" != "-" ]; then
+        load=(-d "load='$states/burnin.$7.bin'")
+    fi
+    if [ "$7" = "-" ] || [ -s "$states/burnin.$7.bin" ]; then
+        out=$("$slim" -s "$6" -d "alpha=$2" -d "selfing=$3" -d "bias=$4" "${load[@]}" "$script" 2>/dev/null | tail -n 1)
+    fi
+    if [ -z "$out" ]; then
+        echo "Warning: run $1 (alpha $2, selfing $3, bias $4, seed $6) failed" >&2
+        out="NA	NA"
+    fi
+    printf "%s\t%s\t%s\t%s\t%s\t%s\t%s\n" "$1" "$2" "$3" "$4" "$5" "$6" "$out"
+}
+export -f runBurnin runOne
+export slim script burnin burnin_bias
+
+if [ "$burnin" -gt 0 ]; then
+    if [ -z "$states" ]; then
+        states=$(mktemp -d) || exit 1
+        trap 'rm -rf "$states"' EXIT
+    elif ! mkdir -p "$states"; then
+        echo -e "\nERROR: Cannot create directory $states\n" >&2
+        exit 1
+    fi
+    export states
+    k=0
+    for a in ${alpha//,/ }; do
+        for s in ${selfing//,/ }; do
+            for ((r=1;r<=reps;r++)); do
+                echo "$k $a $s $r $((seed+k))"
+                k=$((k+1))
+            done
+        done
+    done | xargs -P "$threads" -n 5 bash -c 'runBurnin "$@"' _
+    set -- ${alpha//,/ }
+    k=$#
+    set -- ${selfing//,/ }
+    seed=$((seed+k*$#*reps))
+fi
+
+i=0
+k=0
+for a in ${alpha//,/ }; do
+    for s in ${selfing//,/ }; do
+        for b in ${bias//,/ }; do
+            for ((r=1;r<=reps;r++)); do
+                echo "$i $a $s $b $r $((seed+i)) $([ "$burnin" -gt 0 ] && echo $((k+r-1)) || echo -)"
+                i=$((i+1))
+            done
+        done
+        k=$((k+reps))
+    done
+done | xargs -P "$threads" -n 7 bash -c 'runOne "$@"' _ | sort -n -k1,1 | cut -f2- | (echo -e "alpha\tselfing\tbias\treplicate\tseed\tws_sw\tgc"; cat)
@@ -0,0 +1,996 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Loaders for the region and site lists, and the vcf input shared by estDAF and makeDFE-alpha
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "scan.h"
+#include "input.h"
+#include "vcf.h"
+#include "contig.h"
+#include "gcclass.h"
+#define merror "\nERROR: System out of memory\n"
+#define pipe_chunk 4194304
+#define chunk_free 0
+#define chunk_read 1
+#define chunk_parsed 2
+
+const char *const gc_names[gc_n] = {"all", "WS", "SW", "SS", "WW", "SSWW"};
+
+typedef struct{
+    char *jobs;
+    size_t size;
+    int job_n, next;
+    void (*run)(void *job);
+    pthread_mutex_t lock;
+}Pool_s;
+
+typedef struct{
+    Reader_s *reader;
+    Chunk_s *chunks;
+    int chunk_n;
+    int64_t filled, parsed, end;
+    void *job;
+    void (*parse)(void *job, Chunk_s *chunk);
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+}Pipe_s;
+
+typedef struct{
+    Reader_s in;
+    Keys_s *coords;
+    Pops_s *pops;
+    Tally_s *tally;
+    int ploidy, parsers, grp_n, samples, coord_hi;
+}TallyJob_s;
+
+static void *runJobs(void *arg);
+static int fillChunk(Reader_s *reader, Chunk_s *chunk, char **line, size_t *len);
+static void *readChunks(void *arg);
+static void *parseChunks(void *arg);
+static void freeChunk(Chunk_s *chunk);
+static void orderError(uint64_t key, uint64_t prev);
+static void indexPops(Source_s *src, Pops_s *pops, int ploidy, int partial);
+static void runTally(void *arg);
+static void parseTally(void *arg, Chunk_s *chunk);
+static void mergeTally(void *arg, Chunk_s *chunk);
+static void countGroup(TallyJob_s *job, int g, unsigned char *a1, unsigned char *a2, int n, int *m, int *n00, int *n11, int *nmiss);
+static int indexVcf(Bgzf_s *vcf_file, Index_s *idx, int64_t **offsets);
+static int cmpOffset(const void *a, const void *b);
+static int chrAt(FILE *vcf_file, int64_t offset, int64_t start, int64_t *line_pos, char *name);
+
+Region_s *readGenes(FILE *gene_file, Keys_s *keys){
+    
+    int max=0, chr;
+    char *p, *eol, *temp;
+    Contig_s last={0};
+    Region_s *list=NULL;
+    Map_s *map;
+    
+    map = mapFile(gene_file);
+    
+    while(mapLine(map, &p, &eol)){
+        temp = nextField(p, eol);
+        if((chr = contigField(&last, temp, eol)) < 0)
+            continue;
+        if(keys->n == max){
+            max = max == 0 ? 1024 : max * 2;
+            if((list = realloc(list, max*sizeof(Region_s))) == NULL){
+                fprintf(stderr,merror);
+                exit(EXIT_FAILURE);
+            }
+        }
+        copyField(list[keys->n].id, p, 49);
+        list[keys->n].chr = chr;
+        temp = nextField(temp, eol);
+        list[keys->n].start = atoi(temp);
+        temp = nextField(temp, eol);
+        list[keys->n].stop = atoi(temp);
+        keysAdd(keys, list[keys->n].chr, list[keys->n].start, list[keys->n].stop);
+    }
+    
+    unmapFile(map);
+    fclose(gene_file);
+    keysSort(keys, list, sizeof(Region_s));
+    
+    return list;
+}
+
+Keys_s *readTarget(FILE *target_file){
+    
+    int chr, start;
+    char *p, *eol, *temp;
+    Contig_s last={0};
+    Keys_s *list;
+    Map_s *map;
+    
+    map = mapFile(target_file);
+    list = keysInit(0, 0);
+    
+    while(mapLine(map, &p, &eol)){
+        temp = nextField(p, eol);
+        if(isdigit(temp[0]) == 0 || (chr = contigField(&last, p, eol)) < 0)
+            continue;
+        start = atoi(temp);
+        temp = nextField(temp, eol);
+        keysAdd(list, chr, start, atoi(temp));
+    }
+    
+    unmapFile(map);
+    fclose(target_file);
+    keysSort(list, NULL, 0);
+    
+    return list;
+}
+
+Keys_s *readSites(FILE *site_file, Keys_s *coords, Keys_s *target, Keys_s *genes){
+    
+    int max=1, coord_hi=0, target_hi=0, gene_hi=0, chr, pos;
+    char *p, *eol, *temp;
+    Contig_s last={0};
+    uint64_t key, prev=0;
+    Keys_s *list;
+    Map_s *map;
+    
+    map = mapFile(site_file);
+    
+    if(map->mapped){
+        for(p=map->data;(p=memchr(p, '\n', map->end - p)) != NULL;p++)
+            max++;
+    }
+    
+    list = keysInit(1, map->mapped ? max : 0);
+    
+    while(mapLine(map, &p, &eol)){
+        temp = nextField(p, eol);
+        if(isdigit(temp[0]) == 0 || (chr = contigField(&last, p, eol)) < 0)
+            continue;
+        pos = atoi(temp);
+        key = makeKey(chr, pos);
+        if(key < prev){
+            coord_hi = keySearchUpper(coords, key);
+            target_hi = target != NULL ? keySearchUpper(target, key) : 0;
+            gene_hi = genes != NULL ? keySearchUpper(genes, key) : 0;
+        }
+        prev = key;
+        if(keyOverlaps(coords, coord_hi = keyUpper(coords, coord_hi, key), key, NULL) == 0)
+            continue;
+        if(target != NULL && keyOverlaps(target, target_hi = keyUpper(target, target_hi, key), key, NULL) == 0)
+            continue;
+        if(genes != NULL && keyOverlaps(genes, gene_hi = keyUpper(genes, gene_hi, key), key, NULL) == 0)
+            continue;
+        keysAdd(list, chr, pos, pos);
+    }
+    
+    unmapFile(map);
+    fclose(site_file);
+    keysSort(list, NULL, 0);
+    
+    return list;
+}
+
+Source_s *sourceOpen(Bgzf_s *vcf_file, const char *vcf_name){
+    
+    int i, n, contigs=0;
+    char *line=NULL, *temp;
+    size_t len=0;
+    Source_s *src;
+    
+    if((src = calloc(1, sizeof(Source_s))) == NULL || (src->name = strdup(vcf_name)) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    src->vcf_file = vcf_file;
+    src->part_n = 1;
+    
+    if(vcf_file->bgzf == 0 && (src->cache = cacheOpen(vcf_file->fp)) != NULL){
+        src->samples = src->cache->samples;
+        src->header = src->cache->header;
+        return src;
+    }
+    
+    while(bgzfPeek(vcf_file) == '#'){
+        if(bgzfGetline(&line, &len, vcf_file) == -1)
+            break;
+        lineTerminator(line);
+        if(contigHeader(line) >= 0)
+            contigs++;
+        if(strncmp(line, "#CHROM", 6) != 0)
+            continue;
+        free(src->line);
+        if((src->line = strdup(line)) == NULL){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+        src->header = src->line;
+        temp = strtok(line,"\t");
+        if(strcmp(temp, "#CHROM") == 0){
+            for(i=1, n=0;temp != NULL;i++){
+                if(i > 9)
+                    n++;
+                temp = strtok(NULL,"\t");
+            }
+            src->samples = n;
+        }
+    }
+    
+    free(line);
+    
+    src->data = bgzfTell(vcf_file);
+    
+    if(vcf_file->bgzf == 1)
+        src->idx = indexLoad(vcf_name);
+    else if(contigs == 0 && indexVcf(vcf_file, NULL, &src->offsets) > 0){
+        free(src->offsets);
+        src->offsets = NULL;
+    }
+    
+    return src;
+}
+
+void sourcePops(Source_s *src, Pops_s *pops, int ploidy){
+    
+    int g;
+    const char *p;
+    
+    if(src->tally != NULL){
+        if(src->tally->ploidy != ploidy || src->tally->pops != (pops != NULL) || (pops != NULL && pops->n != src->tally->grp_n)){
+            fprintf(stderr,"\nERROR: The saved counts were made with another -ploidy or -pops\n\n");
+            exit(EXIT_FAILURE);
+        }
+        for(g=0,p=src->tally->names;pops != NULL && g<pops->n;g++,p+=strlen(p)+1){
+            if(strcmp(p, pops->groups[g].id) != 0){
+                fprintf(stderr,"\nERROR: The groups of the -pops file differ from those of the saved counts (%s and %s)\n\n", pops->groups[g].id, p);
+                exit(EXIT_FAILURE);
+            }
+            pops->groups[g].size = src->tally->sizes[g];
+        }
+        return;
+    }
+    
+    indexPops(src, pops, ploidy, 0);
+}
+
+int sourceSplit(Source_s *src, int *threads, int chrom){
+    
+    free(src->offsets);
+    src->offsets = NULL;
+    src->chrom = chrom;
+    src->part_n = 1;
+    
+    if(src->cache != NULL || src->tally != NULL){
+        src->part_n = *threads;
+        return src->part_n;
+    }
+    
+    if(*threads == 1)
+        return 1;
+    
+    if(bgzfTell(src->vcf_file) != src->data)
+        bgzfSeek(src->vcf_file, src->data);
+    
+    if((src->part_n = indexVcf(src->vcf_file, src->idx, &src->offsets)) == 0){
+        fprintf(stderr,"Warning: -threads requires a regular or indexed vcf-file, using a single thread\n");
+        free(src->offsets);
+        src->offsets = NULL;
+        src->part_n = 1;
+        *threads = 1;
+    }
+    
+    return src->part_n;
+}
+
+void sourceReader(Source_s *src, Reader_s *reader, int i, Region_s *regions, int reg_n){
+    
+    memset(reader, 0, sizeof(Reader_s));
+    reader->vcf_file = src->vcf_file;
+    reader->stop = -1;
+    reader->idx = src->idx;
+    reader->regions = regions;
+    reader->reg_n = reg_n;
+    reader->seek = reg_n > 0;
+    reader->header = src->header;
+    reader->cache = src->cache;
+    reader->tally = src->tally;
+    
+    if(src->tally != NULL){
+        reader->first = tallySplit(src->tally, i, src->part_n, src->chrom);
+        reader->last = tallySplit(src->tally, i + 1, src->part_n, src->chrom);
+    }
+    else if(src->cache != NULL){
+        reader->first = cacheSplit(src->cache, i, src->part_n, src->chrom);
+        reader->last = cacheSplit(src->cache, i + 1, src->part_n, src->chrom);
+    }
+    else if(src->offsets != NULL){
+        if((reader->vcf_file = bgzfOpen(src->name)) == NULL){
+            fprintf(stderr,"\nERROR: Cannot open file %s\n\n", src->name);
+            exit(EXIT_FAILURE);
+        }
+        bgzfSeek(reader->vcf_file, src->offsets[i]);
+        reader->stop = src->offsets[i+1];
+    }
+    else if(bgzfTell(src->vcf_file) != src->data)
+        bgzfSeek(src->vcf_file, src->data);
+}
+
+void readerClose(Source_s *src, Reader_s *reader){
+    
+    if(reader->vcf_file != src->vcf_file)
+        bgzfClose(reader->vcf_file);
+    
+    reader->vcf_file = NULL;
+}
+
+void sourceClose(Source_s *src){
+    
+    if(src->idx != NULL)
+        indexFree(src->idx);
+    if(src->cache != NULL)
+        cacheClose(src->cache);
+    if(src->vcf_file != NULL)
+        bgzfClose(src->vcf_file);
+    free(src->offsets);
+    free(src->line);
+    free(src->name);
+    free(src);
+}
+
+Tally_s *sourceTally(Source_s *src, Pops_s *pops, Keys_s *coords, int ploidy, int threads, int parsers, Stats_s *stats){
+    
+    int i, job_n;
+    TallyJob_s *jobs;
+    Tally_s *tally;
+    
+    indexPops(src, pops, ploidy, 1);
+    
+    job_n = sourceSplit(src, &threads, 1);
+    
+    if((jobs = calloc(job_n, sizeof(TallyJob_s))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    for(i=0;i<job_n;i++){
+        sourceReader(src, &jobs[i].in, i, NULL, 0);
+        jobs[i].coords = coords;
+        jobs[i].pops = pops;
+        jobs[i].ploidy = ploidy;
+        jobs[i].parsers = parsers;
+        jobs[i].grp_n = pops != NULL ? pops->n : 1;
+        jobs[i].samples = src->samples;
+        jobs[i].tally = tallyInit(pops, NULL, src->samples, ploidy);
+    }
+    
+    runPool(jobs, sizeof(TallyJob_s), job_n, threads, runTally);
+    
+    tally = tallyInit(pops, src->header, src->samples, ploidy);
+    
+    for(i=0;i<job_n;i++){
+        tallyAppend(tally, jobs[i].tally);
+        tallyFree(jobs[i].tally);
+        statsAdd(&stats->count, &jobs[i].in.count);
+        readerClose(src, &jobs[i].in);
+    }
+    
+    free(jobs);
+    
+    return tally;
+}
+
+Source_s *sourceCounts(Tally_s *tally){
+    
+    Source_s *src;
+    
+    if((src = calloc(1, sizeof(Source_s))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    src->tally = tally;
+    src->part_n = 1;
+    src->samples = tally->sizes[0];
+    
+    return src;
+}
+
+ssize_t readLine(Reader_s *reader, char **line, size_t *len){
+    
+    int chr, pos;
+    char *temp;
+    int64_t offset;
+    ssize_t read;
+    Region_s *reg;
+    
+    while(1){
+        if(reader->seek == 1){
+            reader->seek = 0;
+            if(reader->reg_i >= reader->reg_n)
+                return -1;
+            reg = &reader->regions[reader->reg_i];
+            if((offset = indexQuery(reader->idx, reg->chr, reg->start, reg->stop)) < 0){
+                reader->reg_i++;
+                reader->seek = 1;
+                continue;
+            }
+            if(offset > bgzfTell(reader->vcf_file))
+                bgzfSeek(reader->vcf_file, offset);
+        }
+        if(reader->stop >= 0 && bgzfTell(reader->vcf_file) >= reader->stop)
+            return -1;
+        if((read = bgzfGetline(line, len, reader->vcf_file)) != -1)
+            reader->count.bytes += read;
+        if(read == -1 || reader->reg_n == 0 || (*line)[0] == '#' || (temp = strchr(*line, '\t')) == NULL)
+            return read;
+        chr = contigLookup(&reader->contig, *line, temp - *line);
+        pos = atoi(temp);
+        while(reader->reg_i < reader->reg_n && (chr > reader->regions[reader->reg_i].chr || (chr == reader->regions[reader->reg_i].chr && pos > reader->regions[reader->reg_i].stop))){
+            reader->reg_i++;
+            reader->seek = 1;
+        }
+        if(reader->reg_i >= reader->reg_n)
+            return -1;
+        if(chr < reader->regions[reader->reg_i].chr || pos < reader->regions[reader->reg_i].start)
+            continue;
+        reader->seek = 0;
+        return read;
+    }
+}
+
+void runPool(void *jobs, size_t size, int job_n, int threads, void (*run)(void *job)){
+    
+    int i;
+    Pool_s pool;
+    pthread_t *tid;
+    
+    if(threads <= 1){
+        for(i=0;i<job_n;i++)
+            run((char *)jobs + i*size);
+        return;
+    }
+    
+    if(threads > job_n)
+        threads = job_n;
+    
+    if((tid = malloc(threads*sizeof(pthread_t))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    pool.jobs = jobs;
+    pool.size = size;
+    pool.job_n = job_n;
+    pool.next = 0;
+    pool.run = run;
+    pthread_mutex_init(&pool.lock, NULL);
+    
+    for(i=0;i<threads;i++){
+        if(pthread_create(&tid[i], NULL, runJobs, &pool) != 0){
+            fprintf(stderr,"\nERROR: Cannot create thread\n\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+    for(i=0;i<threads;i++)
+        pthread_join(tid[i], NULL);
+    
+    pthread_mutex_destroy(&pool.lock);
+    free(tid);
+}
+
+static void *runJobs(void *arg){
+    
+    int i;
+    Pool_s *pool = arg;
+    
+    while(1){
+        pthread_mutex_lock(&pool->lock);
+        i = pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+        if(i >= pool->job_n)
+            break;
+        pool->run(pool->jobs + i*pool->size);
+    }
+    
+    return NULL;
+}
+
+void runPipe(Reader_s *reader, int workers, void *job, void (*parse)(void *job, Chunk_s *chunk), void (*merge)(void *job, Chunk_s *chunk)){
+    
+    int i;
+    int64_t seq;
+    char *line=NULL;
+    size_t len=0;
+    uint64_t last=0;
+    Chunk_s *chunk;
+    Count_s count={0};
+    Pipe_s pipe;
+    pthread_t *tid;
+    
+    pipe.chunk_n = workers > 0 ? 2 * workers + 2 : 1;
+    
+    if((pipe.chunks = calloc(pipe.chunk_n, sizeof(Chunk_s))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    if(workers == 0){
+        while(fillChunk(reader, &pipe.chunks[0], &line, &len)){
+            parse(job, &pipe.chunks[0]);
+            if(pipe.chunks[0].last != 0){
+                if(pipe.chunks[0].first < last)
+                    orderError(pipe.chunks[0].first, last);
+                last = pipe.chunks[0].last;
+            }
+            merge(job, &pipe.chunks[0]);
+            statsAdd(&reader->count, &pipe.chunks[0].count);
+        }
+        freeChunk(&pipe.chunks[0]);
+        free(pipe.chunks);
+        free(line);
+        return;
+    }
+    
+    if((tid = malloc((workers+1)*sizeof(pthread_t))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    pipe.reader = reader;
+    pipe.job = job;
+    pipe.parse = parse;
+    pipe.filled = 0;
+    pipe.parsed = 0;
+    pipe.end = -1;
+    pthread_mutex_init(&pipe.lock, NULL);
+    pthread_cond_init(&pipe.cond, NULL);
+    
+    for(i=0;i<=workers;i++){
+        if(pthread_create(&tid[i], NULL, i == 0 ? readChunks : parseChunks, &pipe) != 0){
+            fprintf(stderr,"\nERROR: Cannot create thread\n\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+    for(seq=0;;seq++){
+        chunk = &pipe.chunks[seq % pipe.chunk_n];
+        pthread_mutex_lock(&pipe.lock);
+        while((chunk->state != chunk_parsed || chunk->seq != seq) && (pipe.end < 0 || seq < pipe.end))
+            pthread_cond_wait(&pipe.cond, &pipe.lock);
+        pthread_mutex_unlock(&pipe.lock);
+        if(chunk->state != chunk_parsed || chunk->seq != seq)
+            break;
+        if(chunk->last != 0){
+            if(chunk->first < last)
+                orderError(chunk->first, last);
+            last = chunk->last;
+        }
+        merge(job, chunk);
+        statsAdd(&count, &chunk->count);
+        pthread_mutex_lock(&pipe.lock);
+        chunk->state = chunk_free;
+        pthread_cond_broadcast(&pipe.cond);
+        pthread_mutex_unlock(&pipe.lock);
+    }
+    
+    for(i=0;i<=workers;i++)
+        pthread_join(tid[i], NULL);
+    
+    statsAdd(&reader->count, &count);
+    
+    for(i=0;i<pipe.chunk_n;i++)
+        freeChunk(&pipe.chunks[i]);
+    
+    pthread_mutex_destroy(&pipe.lock);
+    pthread_cond_destroy(&pipe.cond);
+    free(pipe.chunks);
+    free(tid);
+}
+
+int *chunkRecord(Chunk_s *chunk, int size){
+    
+    if(chunk->rec_n + size > chunk->rec_max){
+        chunk->rec_max = (chunk->rec_n + size) * 2;
+        if((chunk->recs = realloc(chunk->recs, chunk->rec_max*sizeof(int))) == NULL){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+    chunk->rec_n += size;
+    
+    return chunk->recs + chunk->rec_n - size;
+}
+
+void chunkOrder(Chunk_s *chunk, uint64_t key){
+    
+    if(key < chunk->last)
+        orderError(key, chunk->last);
+    
+    if(chunk->last == 0)
+        chunk->first = key;
+    chunk->last = key;
+}
+
+void ploidyCheck(const char *header, char *start, char *end, int ploidy, uint64_t key){
+    
+    int i, s;
+    char buf[contig_buf], name[32];
+    const char *p=header;
+    
+    if((s = vcfPloidy(start, end, ploidy)) < 0)
+        return;
+    
+    for(i=0;i<9+s && p != NULL;i++){
+        if((p = strchr(p, '\t')) != NULL)
+            p++;
+    }
+    
+    if(p == NULL){
+        sprintf(name, "%i", s + 1);
+        p = name;
+    }
+    
+    fprintf(stderr,"\nERROR: The call of sample %.*s at %s:%i has another number of alleles than -ploidy %i\n\n", (int)strcspn(p, "\t\r\n"), p, contigName(keyChr(key), buf), keyPos(key), ploidy);
+    exit(EXIT_FAILURE);
+}
+
+static int fillChunk(Reader_s *reader, Chunk_s *chunk, char **line, size_t *len){
+    
+    ssize_t read;
+    
+    chunk->len = 0;
+    chunk->rec_n = 0;
+    chunk->first = 0;
+    chunk->last = 0;
+    memset(&chunk->count, 0, sizeof(Count_s));
+    
+    while(chunk->len < pipe_chunk && (read = readLine(reader, line, len)) != -1){
+        if(chunk->len + read + 1 > chunk->max){
+            chunk->max = chunk->len + read + 1 > pipe_chunk ? (chunk->len + read + 1) * 2 : pipe_chunk * 2;
+            if((chunk->text = realloc(chunk->text, chunk->max)) == NULL){
+                fprintf(stderr,merror);
+                exit(EXIT_FAILURE);
+            }
+        }
+        memcpy(chunk->text + chunk->len, *line, read);
+        chunk->len += read;
+        if(read == 0 || (*line)[read-1] != '\n')
+            chunk->text[chunk->len++] = '\n';
+    }
+    
+    return chunk->len > 0;
+}
+
+static void *readChunks(void *arg){
+    
+    int64_t seq;
+    char *line=NULL;
+    size_t len=0;
+    Chunk_s *chunk;
+    Pipe_s *pipe = arg;
+    
+    for(seq=0;;seq++){
+        chunk = &pipe->chunks[seq % pipe->chunk_n];
+        pthread_mutex_lock(&pipe->lock);
+        while(chunk->state != chunk_free)
+            pthread_cond_wait(&pipe->cond, &pipe->lock);
+        pthread_mutex_unlock(&pipe->lock);
+        if(fillChunk(pipe->reader, chunk, &line, &len) == 0)
+            break;
+        pthread_mutex_lock(&pipe->lock);
+        chunk->seq = seq;
+        chunk->state = chunk_read;
+        pipe->filled = seq + 1;
+        pthread_cond_broadcast(&pipe->cond);
+        pthread_mutex_unlock(&pipe->lock);
+    }
+    
+    pthread_mutex_lock(&pipe->lock);
+    pipe->end = seq;
+    pthread_cond_broadcast(&pipe->cond);
+    pthread_mutex_unlock(&pipe->lock);
+    
+    free(line);
+    
+    return NULL;
+}
+
+static void *parseChunks(void *arg){
+    
+    int64_t seq;
+    Chunk_s *chunk;
+    Pipe_s *pipe = arg;
+    
+    while(1){
+        pthread_mutex_lock(&pipe->lock);
+        while(pipe->parsed == pipe->filled && pipe->end < 0)
+            pthread_cond_wait(&pipe->cond, &pipe->lock);
+        if(pipe->parsed == pipe->filled){
+            pthread_mutex_unlock(&pipe->lock);
+            break;
+        }
+        seq = pipe->parsed++;
+        pthread_mutex_unlock(&pipe->lock);
+        chunk = &pipe->chunks[seq % pipe->chunk_n];
+        pipe->parse(pipe->job, chunk);
+        pthread_mutex_lock(&pipe->lock);
+        chunk->state = chunk_parsed;
+        pthread_cond_broadcast(&pipe->cond);
+        pthread_mutex_unlock(&pipe->lock);
+    }
+    
+    return NULL;
+}
+
+static void freeChunk(Chunk_s *chunk){
+    
+    free(chunk->text);
+    free(chunk->recs);
+    free(chunk->a1);
+    free(chunk->a2);
+}
+
+static void orderError(uint64_t key, uint64_t prev){
+    
+    char buf[contig_buf], prev_buf[contig_buf];
+    
+    fprintf(stderr,"\nERROR: The vcf-file is not sorted by chromosome and position (%s:%i after %s:%i)\n\n", contigName(keyChr(key), buf), keyPos(key), contigName(keyChr(prev), prev_buf), keyPos(prev));
+    exit(EXIT_FAILURE);
+}
+
+static void indexPops(Source_s *src, Pops_s *pops, int ploidy, int partial){
+    
+    if(src->cache != NULL && ploidy > 2){
+        fprintf(stderr,"\nERROR: -ploidy above 2 requires a vcf-file, the genotype cache keeps two alleles of each call\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    if(pops == NULL)
+        return;
+    
+    if(src->cache != NULL && src->header == NULL){
+        fprintf(stderr,"\nERROR: The genotype cache has no sample names, make it again with makeCache to use -pops\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    if(src->header == NULL){
+        fprintf(stderr,"\nERROR: -pops requires a #CHROM line with the sample names\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    popsIndex(pops, src->header, partial);
+}
+
+static void runTally(void *arg){
+    
+    int g, m, n00, n11, nmiss, *counts;
+    int64_t i;
+    TallyJob_s *job = arg;
+    Cache_s *cache=job->in.cache;
+    Row_s *row;
+    
+    if(cache == NULL){
+        runPipe(&job->in, job->parsers, job, parseTally, mergeTally);
+        return;
+    }
+    
+    for(i=job->in.first;i<job->in.last;i++){
+        row = cacheRow(cache, i);
+        job->in.count.lines++;
+        job->in.count.bytes += cache->stride;
+        if(job->coords != NULL && keyOverlaps(job->coords, job->coord_hi = keyUpper(job->coords, job->coord_hi, row->key), row->key, NULL) == 0){
+            if(job->coord_hi == job->coords->n)
+                break;
+            i = cacheFind(cache, i, job->in.last, job->coords->start[job->coord_hi]) - 1;
+            continue;
+        }
+        job->in.count.kept++;
+        counts = tallySite(job->tally, row->key, row->ref, row->alt);
+        for(g=0;g<job->grp_n;g++){
+            if(job->pops == NULL){
+                cacheCount(cache, row, &n00, &n11, &nmiss);
+                m = row->n;
+            }
+            else
+                cacheCountMask(cache, row, job->pops->groups[g].mask, &m, &n00, &n11, &nmiss);
+            if(job->ploidy == 2)
+                vcfAlleles(&m, &n00, &n11, &nmiss);
+            counts[4*g] = m;
+            counts[4*g+1] = n00;
+            counts[4*g+2] = n11;
+            counts[4*g+3] = nmiss;
+        }
+    }
+}
+
+static void parseTally(void *arg, Chunk_s *chunk){
+    
+    int g, k, n, *rec, first=1, coord_hi=0;
+    char *line, *end, *next, *field[10];
+    uint64_t key;
+    TallyJob_s *job = arg;
+    
+    for(line=chunk->text;line<chunk->text+chunk->len;line=next+1){
+        end = next = memchr(line, '\n', chunk->text + chunk->len - line);
+        while(end > line && (end[-1] == '\n' || end[-1] == '\r'))
+            end--;
+        *end = '\0';
+        if(line[0] == '#' || (k = vcfFields(line, end, field, 10)) < 5)
+            continue;
+        chunk->count.lines++;
+        key = makeKey(contigLookup(&chunk->contig, line, field[1] - line - 1), atoi(field[1]));
+        chunkOrder(chunk, key);
+        if(job->coords != NULL){
+            if(first == 1){
+                coord_hi = keySearchUpper(job->coords, key);
+                first = 0;
+            }
+            if(keyOverlaps(job->coords, coord_hi = keyUpper(job->coords, coord_hi, key), key, NULL) == 0)
+                continue;
+        }
+        chunk->count.kept++;
+        if(k >= 10 && job->ploidy > 0)
+            ploidyCheck(job->in.header, field[9], end, job->ploidy, key);
+        n = k < 10 ? 0 : job->ploidy >= 2 ? vcfDosage(field[9], end, job->ploidy, &chunk->a1, &chunk->a2, &chunk->gt_max) : vcfGenotypes(field[9], end, &chunk->a1, &chunk->a2, &chunk->gt_max);
+        if(n > job->samples)
+            n = job->samples;
+        rec = chunkRecord(chunk, 3 + 4 * job->grp_n);
+        rec[0] = keyChr(key);
+        rec[1] = keyPos(key);
+        rec[2] = (unsigned char)field[3][0] | (unsigned char)field[4][0] << 8;
+        for(g=0;g<job->grp_n;g++)
+            countGroup(job, g, chunk->a1, chunk->a2, n, &rec[3+4*g], &rec[4+4*g], &rec[5+4*g], &rec[6+4*g]);
+    }
+}
+
+static void mergeTally(void *arg, Chunk_s *chunk){
+    
+    int *rec;
+    size_t i;
+    TallyJob_s *job = arg;
+    
+    for(i=0;i<chunk->rec_n;i+=3+4*job->grp_n){
+        rec = chunk->recs + i;
+        memcpy(tallySite(job->tally, makeKey(rec[0], rec[1]), rec[2] & 255, rec[2] >> 8), rec + 3, 4*job->grp_n*sizeof(int));
+    }
+}
+
+static void countGroup(TallyJob_s *job, int g, unsigned char *a1, unsigned char *a2, int n, int *m, int *n00, int *n11, int *nmiss){
+    
+    if(job->ploidy >= 2){
+        if(job->pops == NULL)
+            vcfDoseCount(a1, a2, n, job->ploidy, m, n00, n11, nmiss);
+        else
+            popsDoseCount(&job->pops->groups[g], a1, a2, n, job->ploidy, m, n00, n11, nmiss);
+        return;
+    }
+    
+    if(job->pops == NULL){
+        vcfCount(a1, a2, n, n00, n11, nmiss);
+        *m = n;
+    }
+    else
+        popsCount(&job->pops->groups[g], a1, a2, n, m, n00, n11, nmiss);
+}
+
+static int indexVcf(Bgzf_s *vcf_file, Index_s *idx, int64_t **offsets){
+    
+    int i, n=0, max=8, len;
+    int64_t start, end, lo, hi, mid, line_pos=0;
+    char name[contig_max], next[contig_max];
+    struct stat st;
+    
+    if(vcf_file->bgzf == 1){
+        if(idx == NULL)
+            return 0;
+        if((*offsets = malloc((idx->ref_n+1)*sizeof(int64_t))) == NULL){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+        for(i=0;i<idx->ref_n;i++){
+            if(idx->refs[i].chr >= 0 && ((*offsets)[n] = indexQuery(idx, idx->refs[i].chr, 1, INT_MAX)) >= 0)
+                n++;
+        }
+        qsort(*offsets, n, sizeof(int64_t), cmpOffset);
+        (*offsets)[n] = -1;
+        return n;
+    }
+    
+    if(fstat(fileno(vcf_file->fp), &st) != 0 || !S_ISREG(st.st_mode) || (start = ftello(vcf_file->fp)) < 0)
+        return 0;
+    
+    end = st.st_size;
+    
+    if((*offsets = malloc(max*sizeof(int64_t))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    (*offsets)[n++] = start;
+    len = chrAt(vcf_file->fp, start, start, &line_pos, name);
+    
+    while(len > 0){
+        if(len < contig_max - 1)
+            contigId(name, len);
+        lo = line_pos;
+        hi = end;
+        while(hi - lo > 1){
+            mid = lo + (hi - lo) / 2;
+            if(chrAt(vcf_file->fp, mid, start, &line_pos, next) != len || memcmp(next, name, len) != 0)
+                hi = mid;
+            else
+                lo = mid;
+        }
+        len = chrAt(vcf_file->fp, hi, start, &line_pos, name);
+        if(n+1 == max){
+            max *= 2;
+            if((*offsets = realloc(*offsets, max*sizeof(int64_t))) == NULL){
+                fprintf(stderr,merror);
+                exit(EXIT_FAILURE);
+            }
+        }
+        (*offsets)[n++] = line_pos;
+    }
+    
+    (*offsets)[n] = end;
+    fseeko(vcf_file->fp, start, SEEK_SET);
+    
+    return n;
+}
+
+static int cmpOffset(const void *a, const void *b){
+    
+    const int64_t *x = a, *y = b;
+    
+    return (*x > *y) - (*x < *y);
+}
+
+static int chrAt(FILE *vcf_file, int64_t offset, int64_t start, int64_t *line_pos, char *name){
+    
+    int c, len=0;
+    
+    fseeko(vcf_file, offset > start ? offset - 1 : start, SEEK_SET);
+    if(offset > start){
+        while((c=fgetc(vcf_file)) != '\n' && c != EOF);
+    }
+    
+    *line_pos = ftello(vcf_file);
+    
+    while(len < contig_max - 1 && (c=fgetc(vcf_file)) != EOF && c != '\t' && c != '\n' && c != '#')
+        name[len++] = c;
+    
+    return len;
+}
+
+void lineTerminator(char *line){
+    
+    int i;
+    
+    for(i=0;line[i]!=0;i++){
+        if(line[i] == '\n' || line[i] == '\r')
+            line[i] = '\0';
+    }
+}
@@ -0,0 +1,103 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Loaders for the region and site lists, and the vcf input shared by estDAF and makeDFE-alpha
+ 
+ readGenes, readTarget and readSites load the gene, region and site files into packed keys. readSites keeps only the sites inside the coordinates and the optional regions and genes (all indexed with keysIndex, as they may overlap), and leaves the lists it filters with for the caller to free.
+ 
+ A Source_s is a vcf-file, plain or compressed with bgzip, or a genotype cache opened once with sourceOpen, which reads the header and loads the index. sourceSplit divides it into one part per chromosome for -threads (or several parts of a cache), and sourceReader sets up a Reader_s for one part, seeking back to the first data line so that a source can be scanned again (except when it is read from a pipe). readLine returns the lines of a reader, skipping to the given regions through the index. runPool runs a list of jobs on a number of threads.
+ 
+ sourceTally counts the genotypes of each group at every line of a source inside coords (indexed with keysIndex, or all lines when NULL) into a Tally_s (see tally.h), and sourceCounts makes a source of a tally, which dafScan and sfsScan read instead of genotypes. The tally is not freed by sourceClose.
+ 
+ runPipe reads the lines of a reader in chunks of about 4 MB and passes each chunk to parse and then, in the order of the file, to merge. With workers, one thread reads the chunks, the workers parse them in parallel and the calling thread merges them, so a single chromosome is spread over workers + 2 threads. parse turns the lines into records of ints stored in the chunk with chunkRecord, together with counts of the lines and sites that are added to the reader's after the merge, and has to leave the job unchanged. It passes the key of each line to chunkOrder, which stops the program when the vcf-file is not sorted by chromosome and position, within or across the chunks. With -ploidy, parse passes the calls to ploidyCheck, which stops the program at the first call that has another number of alleles, naming the sample from the header of the reader. The chunks wait in a ring of 2 * workers + 2 that is handed between the stages under one mutex, taken once per chunk.
+ */
+
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "bgzf.h"
+#include "contig.h"
+#include "gtcache.h"
+#include "merge.h"
+#include "pops.h"
+#include "stats.h"
+#include "tally.h"
+#define seek_gap 16384
+
+typedef struct{
+    int chr, start, stop;
+    char id[50];
+}Region_s;
+
+typedef struct{
+    Bgzf_s *vcf_file;
+    char *name, *line;
+    const char *header;
+    Cache_s *cache;
+    Tally_s *tally;
+    Index_s *idx;
+    int samples, part_n, chrom;
+    int64_t data, *offsets;
+}Source_s;
+
+typedef struct{
+    char *text;
+    size_t len, max, rec_n, rec_max;
+    int *recs, gt_max, state;
+    unsigned char *a1, *a2;
+    int64_t seq;
+    uint64_t first, last;
+    Contig_s contig;
+    Count_s count;
+}Chunk_s;
+
+typedef struct{
+    Bgzf_s *vcf_file;
+    Index_s *idx;
+    Region_s *regions;
+    int reg_n, reg_i, seek;
+    int64_t stop, first, last;
+    const char *header;
+    Cache_s *cache;
+    Tally_s *tally;
+    Contig_s contig;
+    Count_s count;
+}Reader_s;
+
+Region_s *readGenes(FILE *gene_file, Keys_s *keys);
+Keys_s *readTarget(FILE *target_file);
+Keys_s *readSites(FILE *site_file, Keys_s *coords, Keys_s *target, Keys_s *genes);
+Source_s *sourceOpen(Bgzf_s *vcf_file, const char *vcf_name);
+void sourcePops(Source_s *src, Pops_s *pops, int ploidy);
+int sourceSplit(Source_s *src, int *threads, int chrom);
+void sourceReader(Source_s *src, Reader_s *reader, int i, Region_s *regions, int reg_n);
+void readerClose(Source_s *src, Reader_s *reader);
+void sourceClose(Source_s *src);
+Tally_s *sourceTally(Source_s *src, Pops_s *pops, Keys_s *coords, int ploidy, int threads, int parsers, Stats_s *stats);
+Source_s *sourceCounts(Tally_s *tally);
+ssize_t readLine(Reader_s *reader, char **line, size_t *len);
+void runPool(void *jobs, size_t size, int job_n, int threads, void (*run)(void *job));
+void runPipe(Reader_s *reader, int workers, void *job, void (*parse)(void *job, Chunk_s *chunk), void (*merge)(void *job, Chunk_s *chunk));
+int *chunkRecord(Chunk_s *chunk, int size);
+void chunkOrder(Chunk_s *chunk, uint64_t key);
+void ploidyCheck(const char *header, char *start, char *end, int ploidy, uint64_t key);
+void lineTerminator(char *line);
+
+#endif
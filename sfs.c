@@ -0,0 +1,965 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ SFS and sites/divergence counts for DFE-alpha, the core of makeDFE-alpha
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "sfs.h"
+#include "vcf.h"
+#include "merge.h"
+#include "gtcache.h"
+#define merror "\nERROR: System out of memory\n"
+
+typedef struct{
+    Reader_s in;
+    int ploidy, parsers, project, *grp_called;
+    double *proj;
+    Keys_s *mismatch;
+    int ind_i, use, width, grp_n, *grp_off, *grp_size, *grp_count;
+    Pops_s *pops;
+    Keys_s *sites, *div_keys;
+    Site_s *div;
+    Dense_s *dense;
+    double *counts;
+    int block_size, block_n, block_max;
+    Block_s *blocks;
+    Region_s *genes;
+    Keys_s *gene_keys;
+    int gene_hi, row_n, row_max, row_width, slot[gc_n], *row_gene, *gene_row, *hits, *site_rows;
+    unsigned int *rows;
+    int win_size, win_step, win_chr, win_head, win_n, win_max, win_i, win_names, *win_rec;
+    int64_t win_next;
+    unsigned int *win_sum;
+    Region_s *wins;
+}Job_s;
+
+typedef struct{
+    Block_s *blocks;
+    double *reps;
+    int block_n, rep_n, width, use, *next;
+    uint64_t seed;
+    pthread_mutex_t lock;
+}Boot_s;
+
+static void runJob(void *arg);
+static void scanVcf(Job_s *job);
+static void parseChunk(void *arg, Chunk_s *chunk);
+static void mergeChunk(void *arg, Chunk_s *chunk);
+static void scanCache(Job_s *job);
+static void scanTally(Job_s *job);
+static void countGenotypes(Job_s *job, int g, unsigned char *a1, unsigned char *a2, int n, int *m, int *n00, int *n11, int *nmiss);
+static void cacheGenotypes(Job_s *job, int g, Row_s *row, int *m, int *n00, int *n11, int *nmiss);
+static int matchDiv(Job_s *job, uint64_t key, int *div_i, Site_s *site);
+static int derivedCount(int rd, int n, int n00, int n11);
+static void addSite(Job_s *job, uint64_t key, int mask, int rd);
+static void projectSite(int n, int d, int size, double *w);
+static int matchGenes(Job_s *job, uint64_t key);
+static int geneRow(Job_s *job, int gene_i);
+static unsigned int *addGene(Job_s *job, int gene_i);
+static void windowAdd(Job_s *job, uint64_t key, int mask, int rd);
+static void windowMove(Job_s *job, int64_t pos);
+static void windowSite(Job_s *job, int *rec, int sign);
+static void printGene(FILE **out, Sfs_s *sfs, char *id, unsigned int *row);
+static void printSfs(FILE *out, double *counts, int size, int digits);
+static Block_s *mergeBlocks(Job_s *jobs, int job_n, int width, int *n);
+static void *runBoot(void *arg);
+static uint64_t nextRandom(uint64_t *state);
+static Region_s *seekRegions(Keys_s *sites, int *n);
+
+Sfs_s *sfsScan(Source_s *src, Pops_s *pops, Keys_s *sites, Keys_s *div_keys, Site_s *div, Dense_s *dense, Region_s *genes, Keys_s *gene_keys, int use, int threads, int parsers, int ploidy, int project, int block_size, int win_size, int win_step, Stats_s *stats){
+    
+    int i, j, k, g, r, job_n, reg_n=0, row_n=0, width=0, grp_n=pops != NULL ? pops->n : 1, *grp_off, *grp_size, *gene_out=NULL;
+    unsigned int *row;
+    Region_s *regions=NULL, *names;
+    Job_s *jobs;
+    Sfs_s *sfs;
+    
+    sourcePops(src, pops, ploidy);
+    
+    if((grp_off = malloc(grp_n*sizeof(int))) == NULL || (grp_size = malloc(grp_n*sizeof(int))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    for(g=0;g<grp_n;g++){
+        grp_size[g] = (pops != NULL ? pops->groups[g].size : src->samples) * (ploidy > 0 ? ploidy : 1);
+        if(project > grp_size[g]){
+            fprintf(stderr,"\nERROR: -project %i is larger than the %i genotypes of %s\n\n", project, grp_size[g], pops != NULL ? pops->groups[g].id : "the vcf-file");
+            exit(EXIT_FAILURE);
+        }
+        if(project > 0)
+            grp_size[g] = project;
+        grp_off[g] = width;
+        width += grp_size[g] + 3;
+    }
+    
+    if(src->idx != NULL)
+        regions = seekRegions(sites, &reg_n);
+    
+    job_n = sourceSplit(src, &threads, win_size > 0);
+    
+    if((jobs = calloc(job_n, sizeof(Job_s))) == NULL || (sfs = calloc(1, sizeof(Sfs_s))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    for(i=0;i<job_n;i++){
+        sourceReader(src, &jobs[i].in, i, regions, reg_n);
+        jobs[i].sites = sites;
+        jobs[i].div_keys = div_keys;
+        jobs[i].div = div;
+        jobs[i].dense = dense;
+        jobs[i].ind_i = src->samples;
+        jobs[i].width = width;
+        jobs[i].pops = pops;
+        jobs[i].grp_n = grp_n;
+        jobs[i].grp_off = grp_off;
+        jobs[i].grp_size = grp_size;
+        jobs[i].use = use;
+        jobs[i].mismatch = keysInit(1, 0);
+        jobs[i].ploidy = ploidy;
+        jobs[i].parsers = parsers;
+        jobs[i].project = project;
+        jobs[i].block_size = block_size;
+        jobs[i].genes = genes;
+        jobs[i].gene_keys = gene_keys;
+        jobs[i].win_size = win_size;
+        jobs[i].win_step = win_step;
+        for(k=0;k<gc_n;k++){
+            jobs[i].slot[k] = -1;
+            if(use & (1 << k)){
+                jobs[i].slot[k] = jobs[i].row_width;
+                jobs[i].row_width += width;
+            }
+        }
+        if((jobs[i].counts = calloc(gc_n*width, sizeof(double))) == NULL || (jobs[i].grp_count = malloc(grp_n*sizeof(int))) == NULL || (jobs[i].grp_called = malloc(grp_n*sizeof(int))) == NULL || (jobs[i].proj = malloc(grp_n*(project+1)*sizeof(double))) == NULL || (jobs[i].win_sum = calloc(jobs[i].row_width, sizeof(unsigned int))) == NULL){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+        if(gene_keys != NULL){
+            if((jobs[i].gene_row = malloc((gene_keys->n+1)*sizeof(int))) == NULL || (jobs[i].hits = malloc((gene_keys->n+1)*sizeof(int))) == NULL || (jobs[i].site_rows = malloc((gene_keys->n+1)*sizeof(int))) == NULL){
+                fprintf(stderr,merror);
+                exit(EXIT_FAILURE);
+            }
+            for(j=0;j<gene_keys->n;j++)
+                jobs[i].gene_row[j] = -1;
+        }
+    }
+    
+    runPool(jobs, sizeof(Job_s), job_n, threads, runJob);
+    
+    for(i=1;i<job_n;i++){
+        for(k=0;k<gc_n*width;k++)
+            jobs[0].counts[k] += jobs[i].counts[k];
+    }
+    
+    for(i=0;i<job_n;i++){
+        statsAdd(&stats->count, &jobs[i].in.count);
+        statsMismatch(stats, jobs[i].mismatch);
+        keysFree(jobs[i].mismatch);
+        row_n += jobs[i].row_n;
+    }
+    
+    sfs->counts = jobs[0].counts;
+    sfs->by_row = gene_keys != NULL || win_size > 0;
+    sfs->project = project;
+    sfs->width = width;
+    sfs->grp_n = grp_n;
+    sfs->grp_off = grp_off;
+    sfs->grp_size = grp_size;
+    sfs->row_width = jobs[0].row_width;
+    sfs->use = use;
+    memcpy(sfs->slot, jobs[0].slot, sizeof(sfs->slot));
+    
+    if(block_size > 0)
+        sfs->blocks = mergeBlocks(jobs, job_n, width, &sfs->block_n);
+    
+    if((sfs->rows = malloc(((size_t)row_n*sfs->row_width+1)*sizeof(unsigned int))) == NULL || (sfs->names = malloc((row_n+1)*sizeof(Region_s))) == NULL || (gene_keys != NULL && (gene_out = malloc((gene_keys->n+1)*sizeof(int))) == NULL)){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    for(j=0;gene_out != NULL && j<gene_keys->n;j++)
+        gene_out[j] = -1;
+    
+    for(i=0;i<job_n;i++){
+        names = win_size > 0 ? jobs[i].wins : genes;
+        for(j=0;j<jobs[i].row_n;j++){
+            row = jobs[i].rows + (size_t)j*sfs->row_width;
+            r = gene_out != NULL ? gene_out[jobs[i].row_gene[j]] : -1;
+            if(r < 0 && sfs->row_n > 0 && strcmp(sfs->names[sfs->row_n-1].id, names[jobs[i].row_gene[j]].id) == 0)
+                r = sfs->row_n - 1;
+            if(r >= 0){
+                for(k=0;k<sfs->row_width;k++)
+                    sfs->rows[(size_t)r*sfs->row_width+k] += row[k];
+            }
+            else{
+                r = sfs->row_n++;
+                sfs->names[r] = names[jobs[i].row_gene[j]];
+                memcpy(sfs->rows + (size_t)r*sfs->row_width, row, sfs->row_width*sizeof(unsigned int));
+            }
+            if(gene_out != NULL)
+                gene_out[jobs[i].row_gene[j]] = r;
+        }
+    }
+    
+    free(gene_out);
+    
+    for(i=0;i<job_n;i++){
+        if(i > 0)
+            free(jobs[i].counts);
+        free(jobs[i].grp_count);
+        free(jobs[i].grp_called);
+        free(jobs[i].proj);
+        free(jobs[i].rows);
+        free(jobs[i].row_gene);
+        free(jobs[i].gene_row);
+        free(jobs[i].hits);
+        free(jobs[i].site_rows);
+        free(jobs[i].win_rec);
+        free(jobs[i].win_sum);
+        free(jobs[i].wins);
+        readerClose(src, &jobs[i].in);
+    }
+    
+    free(regions);
+    free(jobs);
+    
+    return sfs;
+}
+
+void sfsBoot(Sfs_s *sfs, int boot_n, uint64_t seed, int threads){
+    
+    int i, next=0;
+    Boot_s boot;
+    pthread_t *tid;
+    
+    free(sfs->reps);
+    
+    boot.width = sfs->width;
+    boot.blocks = sfs->blocks;
+    boot.block_n = sfs->block_n;
+    boot.rep_n = boot_n;
+    boot.seed = seed;
+    boot.use = sfs->use;
+    boot.next = &next;
+    
+    if((boot.reps = calloc((size_t)boot_n*gc_n*boot.width, sizeof(double))) == NULL || (tid = malloc(threads*sizeof(pthread_t))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    pthread_mutex_init(&boot.lock, NULL);
+    
+    for(i=0;i<threads;i++){
+        if(pthread_create(&tid[i], NULL, runBoot, &boot) != 0){
+            fprintf(stderr,"\nERROR: Cannot create thread\n\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+    for(i=0;i<threads;i++)
+        pthread_join(tid[i], NULL);
+    
+    pthread_mutex_destroy(&boot.lock);
+    free(tid);
+    
+    sfs->reps = boot.reps;
+    sfs->rep_n = boot_n;
+}
+
+void sfsWrite(Sfs_s *sfs, FILE **out){
+    
+    int j, g, k, digits=sfs->project > 0 ? 2 : 0;
+    double *rep;
+    
+    for(j=0;j<sfs->row_n;j++)
+        printGene(out, sfs, sfs->names[j].id, sfs->rows + (size_t)j*sfs->row_width);
+    
+    if(sfs->by_row)
+        return;
+    
+    for(g=0;g<sfs->grp_n;g++){
+        for(k=0;k<gc_n;k++){
+            if(out[g*gc_n+k] == NULL)
+                continue;
+            printSfs(out[g*gc_n+k], sfs->counts + k*sfs->width + sfs->grp_off[g], sfs->grp_size[g], digits);
+            for(j=0;j<sfs->rep_n;j++){
+                rep = sfs->reps + ((size_t)j*gc_n + k)*sfs->width;
+                printSfs(out[g*gc_n+k], rep + sfs->grp_off[g], sfs->grp_size[g], digits);
+            }
+        }
+    }
+}
+
+void sfsFree(Sfs_s *sfs){
+    
+    int i;
+    
+    for(i=0;i<sfs->block_n;i++)
+        free(sfs->blocks[i].counts);
+    free(sfs->blocks);
+    free(sfs->reps);
+    free(sfs->counts);
+    free(sfs->rows);
+    free(sfs->names);
+    free(sfs->grp_off);
+    free(sfs->grp_size);
+    free(sfs);
+}
+
+static void runJob(void *arg){
+    
+    Job_s *job = arg;
+    
+    if(job->in.tally != NULL)
+        scanTally(job);
+    else if(job->in.cache != NULL)
+        scanCache(job);
+    else
+        scanVcf(job);
+}
+
+static void scanVcf(Job_s *job){
+    
+    runPipe(&job->in, job->parsers, job, parseChunk, mergeChunk);
+    
+    if(job->win_size > 0)
+        windowMove(job, INT64_MAX);
+}
+
+static void parseChunk(void *arg, Chunk_s *chunk){
+    
+    int g, k, m, *rec, chr=0, pos=0, first=1, site_i=0, div_i=0, rd=0, mask=0, n=0, n00=0, n11=0, nmiss=0;
+    char ref, alt, *line, *end, *next, *field[10];
+    uint64_t key;
+    Job_s *job = arg;
+    Keys_s *sites=job->sites;
+    Site_s site;
+    
+    for(line=chunk->text;line<chunk->text+chunk->len;line=next+1){
+        end = next = memchr(line, '\n', chunk->text + chunk->len - line);
+        while(end > line && (end[-1] == '\n' || end[-1] == '\r'))
+            end--;
+        *end = '\0';
+        if(line[0] == '#' || (k = vcfFields(line, end, field, 10)) < 5)
+            continue;
+        chunk->count.lines++;
+        chr = contigLookup(&chunk->contig, line, field[1] - line - 1);
+        pos = atoi(field[1]);
+        key = makeKey(chr, pos);
+        chunkOrder(chunk, key);
+        if(first == 1){
+            site_i = keySearch(sites, key);
+            div_i = job->dense == NULL ? keySearch(job->div_keys, key) : 0;
+            first = 0;
+        }
+        site_i = keySeek(sites, site_i, key);
+        if(keyHit(sites, site_i, key) == 0)
+            continue;
+        rd = matchDiv(job, key, &div_i, &site);
+        ref = field[3][0];
+        if(rd == 1 && ref != site.ref){
+            chunk->count.mismatch++;
+            rec = chunkRecord(chunk, 4);
+            rec[0] = -1;
+            rec[1] = rd;
+            rec[2] = chr;
+            rec[3] = pos;
+            continue;
+        }
+        alt = field[4][0];
+        mask = 1;
+        if(rd == 0 || alt == site.alt)
+            mask |= classMask(gc_dot, ref, alt, rd);
+        mask &= job->use;
+        if(mask == 0){
+            chunk->count.gc_skip++;
+            continue;
+        }
+        chunk->count.kept++;
+        if(k >= 10 && job->ploidy > 0)
+            ploidyCheck(job->in.header, field[9], end, job->ploidy, key);
+        n = k < 10 ? 0 : job->ploidy >= 2 ? vcfDosage(field[9], end, job->ploidy, &chunk->a1, &chunk->a2, &chunk->gt_max) : vcfGenotypes(field[9], end, &chunk->a1, &chunk->a2, &chunk->gt_max);
+        if(n > job->ind_i)
+            n = job->ind_i;
+        rec = chunkRecord(chunk, 4 + 2 * job->grp_n);
+        rec[0] = mask;
+        rec[1] = rd;
+        rec[2] = chr;
+        rec[3] = pos;
+        for(g=0;g<job->grp_n;g++){
+            countGenotypes(job, g, chunk->a1, chunk->a2, n, &m, &n00, &n11, &nmiss);
+            rec[4+2*g] = job->project > 0 ? (rd == 0 ? n11 : n00) : derivedCount(rd, m, n00, n11);
+            rec[5+2*g] = n00 + n11;
+        }
+    }
+}
+
+static void mergeChunk(void *arg, Chunk_s *chunk){
+    
+    int g, *rec;
+    size_t i;
+    Job_s *job = arg;
+    
+    for(i=0;i<chunk->rec_n;i+=rec[0] > 0 ? 4 + 2 * job->grp_n : 4){
+        rec = chunk->recs + i;
+        if(rec[0] < 0){
+            keysAdd(job->mismatch, rec[2], rec[3], rec[3]);
+            continue;
+        }
+        for(g=0;g<job->grp_n;g++){
+            job->grp_count[g] = rec[4+2*g];
+            job->grp_called[g] = rec[5+2*g];
+        }
+        addSite(job, makeKey(rec[2], rec[3]), rec[0], rec[1]);
+    }
+}
+
+static void scanCache(Job_s *job){
+    
+    int g, m, site_i=0, div_i=0, rd=0, mask=0, n00=0, n11=0, nmiss=0;
+    int64_t i;
+    char ref, alt;
+    Keys_s *sites=job->sites;
+    Site_s site;
+    Cache_s *cache=job->in.cache;
+    Row_s *row;
+    
+    for(i=job->in.first;i<job->in.last;i++){
+        row = cacheRow(cache, i);
+        job->in.count.lines++;
+        job->in.count.bytes += cache->stride;
+        site_i = keySeek(sites, site_i, row->key);
+        if(site_i == sites->n)
+            break;
+        if(keyHit(sites, site_i, row->key) == 0){
+            i = cacheFind(cache, i, job->in.last, sites->start[site_i]) - 1;
+            continue;
+        }
+        rd = matchDiv(job, row->key, &div_i, &site);
+        ref = row->ref;
+        if(rd == 1 && ref != site.ref){
+            job->in.count.mismatch++;
+            keysAdd(job->mismatch, keyChr(row->key), keyPos(row->key), keyPos(row->key));
+            continue;
+        }
+        alt = row->alt;
+        mask = 1;
+        if(rd == 0 || alt == site.alt)
+            mask |= classMask(gc_dot, ref, alt, rd);
+        mask &= job->use;
+        if(mask == 0){
+            job->in.count.gc_skip++;
+            continue;
+        }
+        job->in.count.kept++;
+        for(g=0;g<job->grp_n;g++){
+            cacheGenotypes(job, g, row, &m, &n00, &n11, &nmiss);
+            job->grp_count[g] = job->project > 0 ? (rd == 0 ? n11 : n00) : derivedCount(rd, m, n00, n11);
+            job->grp_called[g] = n00 + n11;
+        }
+        addSite(job, row->key, mask, rd);
+    }
+    
+    if(job->win_size > 0)
+        windowMove(job, INT64_MAX);
+}
+
+static void scanTally(Job_s *job){
+    
+    int g, i, m, site_i=0, div_i=0, rd=0, mask=0, n00, n11, *rec;
+    char ref, alt;
+    uint64_t key;
+    Keys_s *sites=job->sites;
+    Site_s site;
+    Tally_s *tally=job->in.tally;
+    
+    for(i=job->in.first;i<job->in.last;i++){
+        key = tally->keys->start[i];
+        rec = tallyRec(tally, i);
+        job->in.count.lines++;
+        job->in.count.bytes += tally->stride*sizeof(int);
+        site_i = keySeek(sites, site_i, key);
+        if(site_i == sites->n)
+            break;
+        if(keyHit(sites, site_i, key) == 0){
+            i = tallyFind(tally, i, job->in.last, sites->start[site_i]) - 1;
+            continue;
+        }
+        rd = matchDiv(job, key, &div_i, &site);
+        ref = rec[0] & 255;
+        if(rd == 1 && ref != site.ref){
+            job->in.count.mismatch++;
+            keysAdd(job->mismatch, keyChr(key), keyPos(key), keyPos(key));
+            continue;
+        }
+        alt = rec[0] >> 8;
+        mask = 1;
+        if(rd == 0 || alt == site.alt)
+            mask |= classMask(gc_dot, ref, alt, rd);
+        mask &= job->use;
+        if(mask == 0){
+            job->in.count.gc_skip++;
+            continue;
+        }
+        job->in.count.kept++;
+        for(g=0;g<job->grp_n;g++){
+            m = rec[1+4*g];
+            n00 = rec[2+4*g];
+            n11 = rec[3+4*g];
+            job->grp_count[g] = job->project > 0 ? (rd == 0 ? n11 : n00) : derivedCount(rd, m, n00, n11);
+            job->grp_called[g] = n00 + n11;
+        }
+        addSite(job, key, mask, rd);
+    }
+    
+    if(job->win_size > 0)
+        windowMove(job, INT64_MAX);
+}
+
+static void countGenotypes(Job_s *job, int g, unsigned char *a1, unsigned char *a2, int n, int *m, int *n00, int *n11, int *nmiss){
+    
+    if(job->ploidy >= 2){
+        if(job->pops == NULL)
+            vcfDoseCount(a1, a2, n, job->ploidy, m, n00, n11, nmiss);
+        else
+            popsDoseCount(&job->pops->groups[g], a1, a2, n, job->ploidy, m, n00, n11, nmiss);
+        return;
+    }
+    
+    if(job->pops == NULL){
+        vcfCount(a1, a2, n, n00, n11, nmiss);
+        *m = n;
+    }
+    else
+        popsCount(&job->pops->groups[g], a1, a2, n, m, n00, n11, nmiss);
+}
+
+static void cacheGenotypes(Job_s *job, int g, Row_s *row, int *m, int *n00, int *n11, int *nmiss){
+    
+    if(job->pops == NULL){
+        cacheCount(job->in.cache, row, n00, n11, nmiss);
+        *m = row->n;
+    }
+    else
+        cacheCountMask(job->in.cache, row, job->pops->groups[g].mask, m, n00, n11, nmiss);
+    
+    if(job->ploidy == 2)
+        vcfAlleles(m, n00, n11, nmiss);
+}
+
+static int matchDiv(Job_s *job, uint64_t key, int *div_i, Site_s *site){
+    
+    if(job->dense != NULL)
+        return denseDiv(job->dense, key, &site->ref, &site->alt);
+    
+    *div_i = keySeek(job->div_keys, *div_i, key);
+    if(keyHit(job->div_keys, *div_i, key) == 0)
+        return 0;
+    *site = job->div[*div_i];
+    
+    return 1;
+}
+
+static int derivedCount(int rd, int n, int n00, int n11){
+    
+    if(rd == 0)
+        return n11 + (n11 > n00 ? n - n00 - n11 : 0);
+    
+    return n00 + (n00 > n11 ? n - n00 - n11 : 0);
+}
+
+static void addSite(Job_s *job, uint64_t key, int mask, int rd){
+    
+    int g, i, j, k, off, count, size, row_n=0, width=job->width;
+    uint64_t block_key;
+    double *block=NULL, *w=NULL;
+    unsigned int *row;
+    
+    if(job->win_size > 0)
+        windowAdd(job, key, mask, rd);
+    
+    if(job->block_size > 0){
+        block_key = makeKey(keyChr(key), keyPos(key) / job->block_size);
+        if(job->block_n == 0 || job->blocks[job->block_n-1].key != block_key){
+            if(job->block_n == job->block_max){
+                job->block_max = job->block_max == 0 ? 256 : job->block_max * 2;
+                if((job->blocks = realloc(job->blocks, job->block_max*sizeof(Block_s))) == NULL){
+                    fprintf(stderr,merror);
+                    exit(EXIT_FAILURE);
+                }
+            }
+            if((job->blocks[job->block_n].counts = calloc(gc_n*width, sizeof(double))) == NULL){
+                fprintf(stderr,merror);
+                exit(EXIT_FAILURE);
+            }
+            job->blocks[job->block_n].key = block_key;
+            job->block_n++;
+        }
+        block = job->blocks[job->block_n-1].counts;
+    }
+    
+    if(job->gene_keys != NULL)
+        row_n = matchGenes(job, key);
+    
+    if(job->project > 0){
+        for(g=0;g<job->grp_n;g++){
+            if(job->grp_called[g] >= job->project)
+                projectSite(job->grp_called[g], job->grp_count[g], job->project, job->proj + g*(job->project+1));
+        }
+    }
+    
+    for(k=0;k<gc_n;k++){
+        if((mask & (1 << k)) == 0)
+            continue;
+        for(g=0;g<job->grp_n;g++){
+            off = k*width + job->grp_off[g];
+            count = job->grp_count[g];
+            size = job->grp_size[g];
+            if(job->project > 0){
+                if(job->grp_called[g] < job->project)
+                    continue;
+                w = job->proj + g*(size+1);
+                for(j=0;j<=size;j++){
+                    job->counts[off+j] += w[j];
+                    if(block != NULL)
+                        block[off+j] += w[j];
+                }
+            }
+            else{
+                job->counts[off+count]++;
+                if(block != NULL)
+                    block[off+count]++;
+            }
+            job->counts[off+size+1]++;
+            if(rd == 1)
+                job->counts[off+size+2]++;
+            if(block != NULL){
+                block[off+size+1]++;
+                if(rd == 1)
+                    block[off+size+2]++;
+            }
+            off = job->slot[k] + job->grp_off[g];
+            for(i=0;i<row_n;i++){
+                row = job->rows + (size_t)job->site_rows[i]*job->row_width;
+                row[off+count]++;
+                row[off+size+1]++;
+                if(rd == 1)
+                    row[off+size+2]++;
+            }
+        }
+    }
+}
+
+static void projectSite(int n, int d, int size, double *w){
+    
+    int j, lo=size-(n-d) > 0 ? size-(n-d) : 0, hi=d < size ? d : size;
+    double p;
+    
+    for(j=0;j<=size;j++)
+        w[j] = 0;
+    
+    p = exp(lgamma(d+1) - lgamma(lo+1) - lgamma(d-lo+1) + lgamma(n-d+1) - lgamma(size-lo+1) - lgamma(n-d-size+lo+1) - lgamma(n+1) + lgamma(size+1) + lgamma(n-size+1));
+    
+    for(j=lo;j<=hi;j++){
+        w[j] = p;
+        p *= (double)(d-j)*(size-j) / ((double)(j+1)*(n-d-size+j+1));
+    }
+}
+
+static int matchGenes(Job_s *job, uint64_t key){
+    
+    int i, j, r, hit_n, n=0;
+    
+    job->gene_hi = keyUpper(job->gene_keys, job->gene_hi, key);
+    hit_n = keyOverlaps(job->gene_keys, job->gene_hi, key, job->hits);
+    
+    for(i=hit_n-1;i>=0;i--){
+        r = geneRow(job, job->hits[i]);
+        for(j=0;j<n && job->site_rows[j] != r;j++);
+        if(j == n)
+            job->site_rows[n++] = r;
+    }
+    
+    return n;
+}
+
+static int geneRow(Job_s *job, int gene_i){
+    
+    if(job->gene_row[gene_i] < 0){
+        if(job->row_n == 0 || strcmp(job->genes[job->row_gene[job->row_n-1]].id, job->genes[gene_i].id) != 0)
+            addGene(job, gene_i);
+        job->gene_row[gene_i] = job->row_n - 1;
+    }
+    
+    return job->gene_row[gene_i];
+}
+
+static unsigned int *addGene(Job_s *job, int gene_i){
+    
+    if(job->row_n == job->row_max){
+        job->row_max = job->row_max == 0 ? 64 : job->row_max * 2;
+        if((job->rows = realloc(job->rows, (size_t)job->row_max*job->row_width*sizeof(unsigned int))) == NULL || (job->row_gene = realloc(job->row_gene, job->row_max*sizeof(int))) == NULL){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+    memset(job->rows + (size_t)job->row_n*job->row_width, 0, job->row_width*sizeof(unsigned int));
+    job->row_gene[job->row_n] = gene_i;
+    job->row_n++;
+    
+    return job->rows + (size_t)(job->row_n-1)*job->row_width;
+}
+
+static void windowAdd(Job_s *job, uint64_t key, int mask, int rd){
+    
+    int g, chr=keyChr(key), pos=keyPos(key), size=job->win_size, step=job->win_step, stride=3+job->grp_n, *rec;
+    int64_t first;
+    
+    if(chr != job->win_chr){
+        windowMove(job, INT64_MAX);
+        job->win_chr = chr;
+        job->win_next = 0;
+    }
+    else
+        windowMove(job, pos);
+    
+    if(job->win_n == 0){
+        first = pos > size ? (pos - size + step - 1) / step : 0;
+        if(first > job->win_next)
+            job->win_next = first;
+    }
+    
+    if(job->win_head + job->win_n == job->win_max){
+        if(job->win_head > 0){
+            memmove(job->win_rec, job->win_rec + (size_t)job->win_head*stride, (size_t)job->win_n*stride*sizeof(int));
+            job->win_head = 0;
+        }
+        else{
+            job->win_max = job->win_max == 0 ? 1024 : job->win_max * 2;
+            if((job->win_rec = realloc(job->win_rec, (size_t)job->win_max*stride*sizeof(int))) == NULL){
+                fprintf(stderr,merror);
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    
+    rec = job->win_rec + (size_t)(job->win_head+job->win_n)*stride;
+    rec[0] = pos;
+    rec[1] = mask;
+    rec[2] = rd;
+    for(g=0;g<job->grp_n;g++)
+        rec[3+g] = job->grp_count[g];
+    job->win_n++;
+    
+    windowSite(job, rec, 1);
+}
+
+static void windowMove(Job_s *job, int64_t pos){
+    
+    int stride=3+job->grp_n, *rec;
+    int64_t start;
+    char buf[contig_buf];
+    Region_s *win;
+    
+    while(job->win_n > 0 && job->win_next*job->win_step + job->win_size < pos){
+        start = job->win_next*job->win_step + 1;
+        while(job->win_n > 0 && (rec = job->win_rec + (size_t)job->win_head*stride)[0] < start){
+            windowSite(job, rec, -1);
+            job->win_head++;
+            job->win_n--;
+        }
+        if(job->win_n > 0){
+            if(job->win_i == job->win_names){
+                job->win_names = job->win_names == 0 ? 1024 : job->win_names * 2;
+                if((job->wins = realloc(job->wins, job->win_names*sizeof(Region_s))) == NULL){
+                    fprintf(stderr,merror);
+                    exit(EXIT_FAILURE);
+                }
+            }
+            win = &job->wins[job->win_i];
+            win->chr = job->win_chr;
+            win->start = start;
+            win->stop = start + job->win_size - 1;
+            snprintf(win->id, sizeof(win->id), "%s\t%i\t%i", contigName(win->chr, buf), win->start, win->stop);
+            memcpy(addGene(job, job->win_i++), job->win_sum, job->row_width*sizeof(unsigned int));
+        }
+        job->win_next++;
+    }
+    
+    if(job->win_n == 0)
+        job->win_head = 0;
+}
+
+static void windowSite(Job_s *job, int *rec, int sign){
+    
+    int g, k, off, size;
+    
+    for(k=0;k<gc_n;k++){
+        if((rec[1] & (1 << k)) == 0)
+            continue;
+        for(g=0;g<job->grp_n;g++){
+            off = job->slot[k] + job->grp_off[g];
+            size = job->grp_size[g];
+            job->win_sum[off+rec[3+g]] += sign;
+            job->win_sum[off+size+1] += sign;
+            if(rec[2] == 1)
+                job->win_sum[off+size+2] += sign;
+        }
+    }
+}
+
+static void printGene(FILE **out, Sfs_s *sfs, char *id, unsigned int *row){
+    
+    int i, g, k, size;
+    unsigned int *r;
+    FILE *fp;
+    
+    for(g=0;g<sfs->grp_n;g++){
+        for(k=0;k<gc_n;k++){
+            if((fp = out[g*gc_n+k]) == NULL)
+                continue;
+            r = row + sfs->slot[k] + sfs->grp_off[g];
+            size = sfs->grp_size[g];
+            fprintf(fp,"%s\t", id);
+            for(i=0;i<=size;i++)
+                fprintf(fp,"%u ", r[i]);
+            fprintf(fp,"\t%u %u\n", r[size+1], r[size+2]);
+        }
+    }
+}
+
+static void printSfs(FILE *out, double *counts, int size, int digits){
+    
+    int i;
+    
+    for(i=0;i<=size;i++)
+        fprintf(out,"%.*f ", digits, counts[i]);
+    fprintf(out,"\n");
+    fprintf(out,"%.0f %.0f\n", counts[size+1], counts[size+2]);
+}
+
+static Block_s *mergeBlocks(Job_s *jobs, int job_n, int width, int *n){
+    
+    int i, j, k, max=1;
+    Block_s *list;
+    
+    for(i=0;i<job_n;i++)
+        max += jobs[i].block_n;
+    
+    if((list = malloc(max*sizeof(Block_s))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    *n = 0;
+    
+    for(i=0;i<job_n;i++){
+        for(j=0;j<jobs[i].block_n;j++){
+            if(*n > 0 && list[*n-1].key == jobs[i].blocks[j].key){
+                for(k=0;k<gc_n*width;k++)
+                    list[*n-1].counts[k] += jobs[i].blocks[j].counts[k];
+                free(jobs[i].blocks[j].counts);
+            }
+            else{
+                list[*n] = jobs[i].blocks[j];
+                *n = *n + 1;
+            }
+        }
+        free(jobs[i].blocks);
+        jobs[i].blocks = NULL;
+        jobs[i].block_n = 0;
+    }
+    
+    return list;
+}
+
+static void *runBoot(void *arg){
+    
+    int i, j, k, r;
+    uint64_t state;
+    double *rep, *block;
+    Boot_s *boot = arg;
+    
+    while(1){
+        pthread_mutex_lock(&boot->lock);
+        r = *boot->next;
+        *boot->next = r + 1;
+        pthread_mutex_unlock(&boot->lock);
+        if(r >= boot->rep_n)
+            break;
+        rep = boot->reps + (size_t)r*gc_n*boot->width;
+        state = boot->seed + r;
+        state = nextRandom(&state);
+        for(i=0;i<boot->block_n;i++){
+            block = boot->blocks[nextRandom(&state) % boot->block_n].counts;
+            for(k=0;k<gc_n;k++){
+                if(boot->use & (1 << k)){
+                    for(j=k*boot->width;j<(k+1)*boot->width;j++)
+                        rep[j] += block[j];
+                }
+            }
+        }
+    }
+    
+    return NULL;
+}
+
+static uint64_t nextRandom(uint64_t *state){
+    
+    uint64_t z;
+    
+    z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    
+    return z ^ (z >> 31);
+}
+
+static Region_s *seekRegions(Keys_s *sites, int *n){
+    
+    int i, chr, pos;
+    Region_s *list;
+    
+    if((list = malloc((sites->n+1)*sizeof(Region_s))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    for(i=0;i<sites->n;i++){
+        chr = keyChr(sites->stop[i]);
+        pos = keyPos(sites->stop[i]);
+        if(*n > 0 && chr == list[*n-1].chr && pos <= list[*n-1].stop + seek_gap)
+            list[*n-1].stop = pos;
+        else{
+            list[*n].chr = chr;
+            list[*n].start = pos;
+            list[*n].stop = pos;
+            *n = *n + 1;
+        }
+    }
+    
+    return list;
+}
+
@@ -0,0 +1,54 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ SFS and sites/divergence counts for DFE-alpha, the core of makeDFE-alpha
+ 
+ sfsScan reads a Source_s once and counts the SFS, sites and divergent sites of the selected sites for each DAF-class set in use (bit k for class k of gcclass.h) and each group of pops, over the whole genome and, with genes or win_size, for each gene or window. With block_size it also keeps the counts of each block of that many bp, which sfsBoot resamples into bootstrap replicates (it can be called again with another seed). With dense (see denseInit) the substitutions are looked up in its bitmaps instead, and div_keys and div can be NULL. The sites, substitutions, genes and pops are only read, so they can be loaded once and used for any number of scans. threads chromosomes are scanned in parallel and parsers threads parse the lines of each of them (see runPipe).
+ 
+ sfsWrite writes the counts of group g and class k to out[g*gc_n+k] (NULL for the files not written): one line per gene or window, or the genome-wide SFS followed by each bootstrap replicate.
+ */
+
+#ifndef SFS_H
+#define SFS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "gcclass.h"
+#include "mummer.h"
+#include "pops.h"
+#include "scan.h"
+#include "stats.h"
+
+typedef struct{
+    uint64_t key;
+    double *counts;
+}Block_s;
+
+typedef struct{
+    double *counts, *reps;
+    unsigned int *rows;
+    Region_s *names;
+    Block_s *blocks;
+    int by_row, project, width, grp_n, *grp_off, *grp_size, slot[gc_n], row_width, row_n, block_n, rep_n, use;
+}Sfs_s;
+
+Sfs_s *sfsScan(Source_s *src, Pops_s *pops, Keys_s *sites, Keys_s *div_keys, Site_s *div, Dense_s *dense, Region_s *genes, Keys_s *gene_keys, int use, int threads, int parsers, int ploidy, int project, int block_size, int win_size, int win_step, Stats_s *stats);
+void sfsBoot(Sfs_s *sfs, int boot_n, uint64_t seed, int threads);
+void sfsWrite(Sfs_s *sfs, FILE **out);
+void sfsFree(Sfs_s *sfs);
+
+#endif
@@ -0,0 +1,111 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Phase timings and counters written with -stats
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "stats.h"
+#include "contig.h"
+
+static double nowSec(void){
+    
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void statsInit(Stats_s *stats){
+    
+    memset(stats, 0, sizeof(Stats_s));
+    stats->start = stats->mark = nowSec();
+    stats->mismatch = keysInit(1, 0);
+}
+
+void statsPhase(Stats_s *stats, const char *name){
+    
+    int i;
+    double now=nowSec();
+    
+    for(i=0;i<stats->phase_n && strcmp(stats->phase[i], name) != 0;i++);
+    
+    if(i == stats->phase_n && i < stats_max){
+        stats->phase[i] = name;
+        stats->phase_n++;
+    }
+    
+    if(i < stats_max)
+        stats->sec[i] += now - stats->mark;
+    
+    stats->mark = now;
+}
+
+void statsAdd(Count_s *total, const Count_s *count){
+    
+    total->lines += count->lines;
+    total->bytes += count->bytes;
+    total->kept += count->kept;
+    total->gc_skip += count->gc_skip;
+    total->mismatch += count->mismatch;
+}
+
+void statsWrite(Stats_s *stats, FILE *out){
+    
+    int i;
+    
+    for(i=0;i<stats->phase_n;i++)
+        fprintf(out,"time_%s\t%.6f\n", stats->phase[i], stats->sec[i]);
+    
+    fprintf(out,"time_total\t%.6f\n", stats->mark - stats->start);
+    fprintf(out,"lines_parsed\t%lld\n", (long long)stats->count.lines);
+    fprintf(out,"bytes_read\t%lld\n", (long long)stats->count.bytes);
+    fprintf(out,"sites_kept\t%lld\n", (long long)stats->count.kept);
+    fprintf(out,"sites_rejected_gc\t%lld\n", (long long)stats->count.gc_skip);
+    fprintf(out,"ref_mismatch\t%lld\n", (long long)stats->count.mismatch);
+}
+
+void statsMismatch(Stats_s *stats, Keys_s *keys){
+    
+    int i;
+    
+    for(i=0;i<keys->n;i++)
+        keysAdd(stats->mismatch, keyChr(keys->start[i]), keyPos(keys->start[i]), keyPos(keys->start[i]));
+}
+
+void statsWarn(Stats_s *stats, FILE *out){
+    
+    int i, j;
+    char buf[contig_buf];
+    Keys_s *keys=stats->mismatch;
+    
+    for(i=0;i<keys->n;i=j){
+        for(j=i;j<keys->n && keyChr(keys->start[j]) == keyChr(keys->start[i]);j++);
+        fprintf(stderr,"Warning: ref alleles differ at %i sites on chr %s\n", j - i, contigName(keyChr(keys->start[i]), buf));
+    }
+    
+    if(out != NULL){
+        for(i=0;i<keys->n;i++)
+            fprintf(out,"%s\t%i\n", contigName(keyChr(keys->start[i]), buf), keyPos(keys->start[i]));
+    }
+    
+    keysFree(keys);
+    stats->mismatch = NULL;
+}
@@ -0,0 +1,52 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Phase timings and counters written with -stats
+ 
+ statsPhase stores the time since the previous phase under the given name. The counters are kept per job and added together with statsAdd. statsWrite writes one tab-delimited name and value per line.
+ 
+ Sites where the vcf-file and the outgroup disagree on the reference base are collected per job and added in genome order with statsMismatch. statsWarn then prints one warning per chromosome, and can also write every site to a file.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "merge.h"
+#define stats_max 16
+
+typedef struct{
+    int64_t lines, bytes, kept, gc_skip, mismatch;
+}Count_s;
+
+typedef struct{
+    int phase_n;
+    double start, mark, sec[stats_max];
+    const char *phase[stats_max];
+    Count_s count;
+    Keys_s *mismatch;
+}Stats_s;
+
+void statsInit(Stats_s *stats);
+void statsPhase(Stats_s *stats, const char *name);
+void statsAdd(Count_s *total, const Count_s *count);
+void statsWrite(Stats_s *stats, FILE *out);
+void statsMismatch(Stats_s *stats, Keys_s *keys);
+void statsWarn(Stats_s *stats, FILE *out);
+
+#endif
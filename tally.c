@@ -0,0 +1,394 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Per-site genotype counts that can be saved and added to
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tally.h"
+#include "contig.h"
+#define merror "\nERROR: System out of memory\n"
+
+static const char tally_magic[4] = {'T', 'L', 'Y', 1};
+
+static void growRecs(Tally_s *tally, int n);
+static void readPart(FILE *in, void *data, size_t size);
+static const char *skipNames(const char *p, int n);
+static void mergeAlleles(uint64_t key, int *a, int b);
+
+Tally_s *tallyInit(Pops_s *pops, const char *header, int samples, int ploidy){
+    
+    int g, i, c, len;
+    const char *p=header, *q;
+    Tally_s *tally;
+    
+    if((tally = calloc(1, sizeof(Tally_s))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    tally->keys = keysInit(1, 0);
+    tally->grp_n = pops != NULL ? pops->n : 1;
+    tally->stride = 1 + 4 * tally->grp_n;
+    tally->ploidy = ploidy;
+    tally->pops = pops != NULL;
+    
+    if((tally->sizes = malloc(tally->grp_n*sizeof(int))) == NULL || (tally->names = malloc(pops != NULL ? pops->n*50 + 1 : 1)) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    for(g=0;g<tally->grp_n;g++){
+        tally->sizes[g] = pops != NULL ? pops->groups[g].size : samples;
+        if(pops != NULL){
+            len = strlen(pops->groups[g].id) + 1;
+            memcpy(tally->names + tally->name_len, pops->groups[g].id, len);
+            tally->name_len += len;
+        }
+    }
+    
+    for(i=0;i<9 && p != NULL;i++){
+        if((p = strchr(p, '\t')) != NULL)
+            p++;
+    }
+    
+    for(c=0;p != NULL && *p != '\0' && *p != '\n' && *p != '\r';c++){
+        for(q=p;*q != '\0' && *q != '\t' && *q != '\n' && *q != '\r';q++);
+        len = q - p;
+        for(g=0;pops != NULL && g<pops->n && (pops->groups[g].mask[c>>6] & ((uint64_t)1 << (c & 63))) == 0;g++);
+        if(pops != NULL && g == pops->n){
+            p = *q == '\t' ? q + 1 : NULL;
+            continue;
+        }
+        if((tally->names = realloc(tally->names, tally->name_len + len + 1)) == NULL){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+        memcpy(tally->names + tally->name_len, p, len);
+        tally->names[tally->name_len+len] = '\0';
+        tally->name_len += len + 1;
+        p = *q == '\t' ? q + 1 : NULL;
+    }
+    
+    return tally;
+}
+
+int *tallySite(Tally_s *tally, uint64_t key, char ref, char alt){
+    
+    int *rec;
+    
+    keysAdd(tally->keys, keyChr(key), keyPos(key), keyPos(key));
+    growRecs(tally, tally->keys->n);
+    
+    rec = tallyRec(tally, tally->keys->n - 1);
+    rec[0] = (unsigned char)ref | (unsigned char)alt << 8;
+    
+    return rec + 1;
+}
+
+void tallyAppend(Tally_s *tally, Tally_s *part){
+    
+    int i, n=tally->keys->n;
+    
+    if(part->keys->n == 0)
+        return;
+    
+    for(i=0;i<part->keys->n;i++)
+        keysAdd(tally->keys, keyChr(part->keys->start[i]), keyPos(part->keys->start[i]), keyPos(part->keys->start[i]));
+    
+    growRecs(tally, tally->keys->n);
+    memcpy(tallyRec(tally, n), part->recs, (size_t)part->keys->n*tally->stride*sizeof(int));
+}
+
+void tallyMerge(Tally_s *tally, Tally_s *batch){
+    
+    int g, i=0, j=0, k, n=0, *recs, *a, *b;
+    const char *p, *q, *first, *second;
+    uint64_t *keys;
+    
+    if(batch->ploidy != tally->ploidy || batch->pops != tally->pops || batch->grp_n != tally->grp_n){
+        fprintf(stderr,"\nERROR: The saved counts were made with another -ploidy or -pops\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    first = skipNames(tally->names, tally->pops ? tally->grp_n : 0);
+    second = skipNames(batch->names, batch->pops ? batch->grp_n : 0);
+    
+    for(p=tally->names,q=batch->names;p<first;p+=strlen(p)+1,q+=strlen(q)+1){
+        if(strcmp(p, q) != 0){
+            fprintf(stderr,"\nERROR: The groups of the -pops file differ from those of the saved counts (%s and %s)\n\n", q, p);
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+    for(q=second;q<batch->names+batch->name_len;q+=strlen(q)+1){
+        for(p=first;p<tally->names+tally->name_len;p+=strlen(p)+1){
+            if(strcmp(p, q) == 0){
+                fprintf(stderr,"\nERROR: Sample %s is already in the saved counts\n\n", q);
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    
+    if((keys = malloc(((size_t)tally->keys->n+batch->keys->n+1)*sizeof(uint64_t))) == NULL || (recs = malloc(((size_t)tally->keys->n+batch->keys->n+1)*tally->stride*sizeof(int))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    while(i < tally->keys->n || j < batch->keys->n){
+        if(j == batch->keys->n || (i < tally->keys->n && tally->keys->start[i] < batch->keys->start[j])){
+            keys[n] = tally->keys->start[i];
+            memcpy(recs + (size_t)n*tally->stride, tallyRec(tally, i++), tally->stride*sizeof(int));
+        }
+        else if(i == tally->keys->n || batch->keys->start[j] < tally->keys->start[i]){
+            keys[n] = batch->keys->start[j];
+            memcpy(recs + (size_t)n*tally->stride, tallyRec(batch, j++), tally->stride*sizeof(int));
+        }
+        else{
+            keys[n] = tally->keys->start[i];
+            a = recs + (size_t)n*tally->stride;
+            b = tallyRec(batch, j++);
+            memcpy(a, tallyRec(tally, i++), tally->stride*sizeof(int));
+            mergeAlleles(keys[n], a, b[0]);
+            for(k=1;k<tally->stride;k++)
+                a[k] += b[k];
+        }
+        n++;
+    }
+    
+    free(tally->keys->start);
+    free(tally->recs);
+    tally->keys->start = tally->keys->stop = keys;
+    tally->keys->n = tally->keys->max = n;
+    tally->recs = recs;
+    tally->rec_max = n;
+    
+    for(g=0;g<tally->grp_n;g++)
+        tally->sizes[g] += batch->sizes[g];
+    
+    if((tally->names = realloc(tally->names, tally->name_len + batch->name_len - (second - batch->names) + 1)) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    memcpy(tally->names + tally->name_len, second, batch->name_len - (second - batch->names));
+    tally->name_len += batch->name_len - (second - batch->names);
+}
+
+int tallyFind(Tally_s *tally, int i, int last, uint64_t key){
+    
+    int lo, hi, mid, step=1;
+    const uint64_t *keys=tally->keys->start;
+    
+    if(i >= last || keys[i] >= key)
+        return i;
+    
+    lo = i;
+    while(lo + step < last && keys[lo+step] < key){
+        lo += step;
+        step <<= 1;
+    }
+    hi = lo + step < last ? lo + step : last;
+    
+    while(hi - lo > 1){
+        mid = lo + (hi - lo) / 2;
+        if(keys[mid] < key)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    
+    return hi;
+}
+
+int tallySplit(Tally_s *tally, int i, int n, int chrom){
+    
+    int b;
+    
+    b = (int64_t)tally->keys->n * i / n;
+    
+    if(chrom && b > 0 && b < tally->keys->n)
+        b = tallyFind(tally, b, tally->keys->n, makeKey(keyChr(tally->keys->start[b-1]) + 1, 0));
+    
+    return b;
+}
+
+void tallyWrite(Tally_s *tally, FILE *out){
+    
+    size_t size;
+    void *block;
+    TallyHead_s head;
+    
+    memset(&head, 0, sizeof(TallyHead_s));
+    memcpy(head.magic, tally_magic, 4);
+    head.grp_n = tally->grp_n;
+    head.ploidy = tally->ploidy;
+    head.pops = tally->pops;
+    head.names = tally->name_len;
+    head.n = tally->keys->n;
+    
+    contigBlock(&block, &size);
+    
+    fwrite(&head, sizeof(TallyHead_s), 1, out);
+    fwrite(tally->sizes, sizeof(int), tally->grp_n, out);
+    fwrite(tally->names, 1, tally->name_len, out);
+    fwrite(tally->keys->start, sizeof(uint64_t), tally->keys->n, out);
+    fwrite(tally->recs, sizeof(int), (size_t)tally->keys->n*tally->stride, out);
+    if(size > 0)
+        fwrite(block, 1, size, out);
+    
+    if(fflush(out) != 0 || ferror(out)){
+        fprintf(stderr,"\nERROR: Cannot write the saved counts\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    free(block);
+}
+
+Tally_s *tallyRead(FILE *in){
+    
+    int i, chr, name_n, *names;
+    size_t size=0, max=0, n;
+    char *block=NULL;
+    TallyHead_s head;
+    Tally_s *tally;
+    
+    if(fread(&head, sizeof(TallyHead_s), 1, in) != 1 || memcmp(head.magic, tally_magic, 3) != 0){
+        fprintf(stderr,"\nERROR: The file of counts was not saved with -save-counts\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    if(head.magic[3] != tally_magic[3]){
+        fprintf(stderr,"\nERROR: The counts were saved by another version of the program\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    if((tally = calloc(1, sizeof(Tally_s))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    if(head.grp_n < 1 || head.names < 0 || head.n < 0 || head.n > INT32_MAX){
+        fprintf(stderr,"\nERROR: The file of counts is truncated or corrupted\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    tally->grp_n = head.grp_n;
+    tally->stride = 1 + 4 * head.grp_n;
+    tally->ploidy = head.ploidy;
+    tally->pops = head.pops;
+    tally->name_len = head.names;
+    tally->keys = keysInit(1, head.n + 1);
+    tally->keys->n = head.n;
+    
+    if((tally->sizes = malloc(head.grp_n*sizeof(int))) == NULL || (tally->names = malloc(head.names+1)) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    growRecs(tally, head.n + 1);
+    
+    readPart(in, tally->sizes, head.grp_n*sizeof(int));
+    readPart(in, tally->names, head.names);
+    readPart(in, tally->keys->start, head.n*sizeof(uint64_t));
+    readPart(in, tally->recs, (size_t)head.n*tally->stride*sizeof(int));
+    
+    do{
+        if(size == max){
+            max = max == 0 ? 65536 : max * 2;
+            if((block = realloc(block, max)) == NULL){
+                fprintf(stderr,merror);
+                exit(EXIT_FAILURE);
+            }
+        }
+        n = fread(block + size, 1, max - size, in);
+        size += n;
+    }while(n > 0);
+    
+    if((names = contigMap(block, size, &name_n)) != NULL){
+        for(i=0;i<tally->keys->n;i++){
+            if((chr = keyChr(tally->keys->start[i])) < contig_base)
+                continue;
+            if(chr - contig_base >= name_n){
+                fprintf(stderr,"\nERROR: The file of counts is truncated or corrupted\n\n");
+                exit(EXIT_FAILURE);
+            }
+            tally->keys->start[i] = makeKey(names[chr-contig_base], keyPos(tally->keys->start[i]));
+        }
+        free(names);
+        keysSort(tally->keys, tally->recs, tally->stride*sizeof(int));
+    }
+    
+    free(block);
+    fclose(in);
+    
+    return tally;
+}
+
+void tallyFree(Tally_s *tally){
+    
+    keysFree(tally->keys);
+    free(tally->recs);
+    free(tally->sizes);
+    free(tally->names);
+    free(tally);
+}
+
+static void growRecs(Tally_s *tally, int n){
+    
+    if(n <= tally->rec_max)
+        return;
+    
+    tally->rec_max = n > 2 * tally->rec_max ? n : 2 * tally->rec_max;
+    if((tally->recs = realloc(tally->recs, (size_t)tally->rec_max*tally->stride*sizeof(int))) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void readPart(FILE *in, void *data, size_t size){
+    
+    if(size > 0 && fread(data, 1, size, in) != size){
+        fprintf(stderr,"\nERROR: The file of counts is truncated or corrupted\n\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static const char *skipNames(const char *p, int n){
+    
+    int i;
+    
+    for(i=0;i<n;i++)
+        p += strlen(p) + 1;
+    
+    return p;
+}
+
+static void mergeAlleles(uint64_t key, int *a, int b){
+    
+    char buf[contig_buf];
+    
+    if((*a & 255) == (b & 255) && (*a >> 8 == b >> 8 || b >> 8 == '.' || *a >> 8 == '.')){
+        if(*a >> 8 == '.')
+            *a = b;
+        return;
+    }
+    
+    fprintf(stderr,"\nERROR: The alleles of %s:%i differ between the saved counts (%c/%c) and the new samples (%c/%c)\n\n", contigName(keyChr(key), buf), keyPos(key), *a & 255, *a >> 8, b & 255, b >> 8);
+    exit(EXIT_FAILURE);
+}
@@ -0,0 +1,61 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Per-site genotype counts that can be saved and added to
+ 
+ A Tally_s holds the ref and alt bases and the m, n00, n11 and nmiss counts of each group (as counted from the genotypes by estDAF and makeDFE-alpha) for every site of a scan, sorted by key. sourceTally (scan.h) counts a vcf-file or genotype cache into one, and sourceCounts turns it back into a source, which is scanned as if its genotypes were read again. Which sites and classes are used, and whether a site is diverged, is decided in that scan, so a saved tally can be used with other sites, genes, windows or substitutions.
+ 
+ tallyWrite saves a tally and tallyRead loads it, giving the chromosome names the ids of this run. tallyMerge adds a tally of other samples (a new batch of the panel) to another, site by site and keeping the sites of either, so the counts of a growing panel are kept without reading the earlier vcf-files again. The two need the same ploidy and groups (same names in the same order), and a sample can only be added once (with pops, only the samples in the groups count). A site that is missing from one of the batches counts as not called in its samples. A site keeps the ALT of the batch that has one when the other called it invariant ('.'), and the program stops when the batches differ in REF or ALT.
+ */
+
+#ifndef TALLY_H
+#define TALLY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "merge.h"
+#include "pops.h"
+
+typedef struct{
+    char magic[4];
+    int grp_n, ploidy, pops, names;
+    int64_t n;
+}TallyHead_s;
+
+typedef struct{
+    Keys_s *keys;
+    int *recs, *sizes;
+    char *names;
+    int grp_n, stride, ploidy, pops, name_len, rec_max;
+}Tally_s;
+
+Tally_s *tallyInit(Pops_s *pops, const char *header, int samples, int ploidy);
+int *tallySite(Tally_s *tally, uint64_t key, char ref, char alt);
+void tallyAppend(Tally_s *tally, Tally_s *part);
+void tallyMerge(Tally_s *tally, Tally_s *batch);
+int tallyFind(Tally_s *tally, int i, int last, uint64_t key);
+int tallySplit(Tally_s *tally, int i, int n, int chrom);
+void tallyWrite(Tally_s *tally, FILE *out);
+Tally_s *tallyRead(FILE *in);
+void tallyFree(Tally_s *tally);
+
+static inline int *tallyRec(Tally_s *tally, int i){
+    
+    return tally->recs + (size_t)i * tally->stride;
+}
+
+#endif
@@ -0,0 +1,234 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Field and genotype scanner for VCF data lines
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#include "vcf.h"
+#define merror "\nERROR: System out of memory\n"
+
+static inline void storeGt(char *field, char *end, unsigned char *a1, unsigned char *a2, int n){
+    
+    a1[n] = field < end && field[0] != '\t' ? field[0] : 0;
+    a2[n] = field + 2 < end && a1[n] != 0 && field[1] != '\t' && field[2] != '\t' ? field[2] : 0;
+}
+
+int vcfFields(char *line, char *end, char **field, int n){
+    
+    int k=1;
+    char *p=line;
+    
+    field[0] = line;
+    
+    while(k < n && (p = memchr(p, '\t', end - p)) != NULL)
+        field[k++] = ++p;
+    
+    return k;
+}
+
+int vcfGenotypes(char *start, char *end, unsigned char **a1, unsigned char **a2, int *max){
+    
+    int n=0;
+    char *p=start;
+    
+    if(end - start + 1 > *max){
+        *max = end - start + 1;
+        if((*a1 = realloc(*a1, *max)) == NULL || (*a2 = realloc(*a2, *max)) == NULL){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+    storeGt(start, end, *a1, *a2, n++);
+
+#if defined(__AVX2__)
+    unsigned int m;
+    __m256i tab = _mm256_set1_epi8('\t');
+    
+    for(;p+32<=end;p+=32){
+        m = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i *)p), tab));
+        while(m != 0){
+            storeGt(p + __builtin_ctz(m) + 1, end, *a1, *a2, n++);
+            m &= m - 1;
+        }
+    }
+#elif defined(__SSE2__)
+    unsigned int m;
+    __m128i tab = _mm_set1_epi8('\t');
+    
+    for(;p+16<=end;p+=16){
+        m = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((__m128i *)p), tab));
+        while(m != 0){
+            storeGt(p + __builtin_ctz(m) + 1, end, *a1, *a2, n++);
+            m &= m - 1;
+        }
+    }
+#endif
+
+    for(;p<end;p++){
+        if(*p == '\t')
+            storeGt(p + 1, end, *a1, *a2, n++);
+    }
+    
+    return n;
+}
+
+void vcfCount(unsigned char *a1, unsigned char *a2, int n, int *n00, int *n11, int *nmiss){
+    
+    int i=0, c00=0, c11=0, cm=0;
+
+#if defined(__AVX2__)
+    __m256i x, y, zero=_mm256_set1_epi8('0'), one=_mm256_set1_epi8('1'), dot=_mm256_set1_epi8('.');
+    
+    for(;i+32<=n;i+=32){
+        x = _mm256_loadu_si256((__m256i *)(a1 + i));
+        y = _mm256_loadu_si256((__m256i *)(a2 + i));
+        c00 += __builtin_popcount((unsigned int)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(x, zero), _mm256_cmpeq_epi8(y, zero))));
+        c11 += __builtin_popcount((unsigned int)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(x, one), _mm256_cmpeq_epi8(y, one))));
+        cm += __builtin_popcount((unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(x, dot), _mm256_cmpeq_epi8(y, dot))));
+    }
+#elif defined(__SSE2__)
+    __m128i x, y, zero=_mm_set1_epi8('0'), one=_mm_set1_epi8('1'), dot=_mm_set1_epi8('.');
+    
+    for(;i+16<=n;i+=16){
+        x = _mm_loadu_si128((__m128i *)(a1 + i));
+        y = _mm_loadu_si128((__m128i *)(a2 + i));
+        c00 += __builtin_popcount((unsigned int)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(x, zero), _mm_cmpeq_epi8(y, zero))));
+        c11 += __builtin_popcount((unsigned int)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(x, one), _mm_cmpeq_epi8(y, one))));
+        cm += __builtin_popcount((unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(x, dot), _mm_cmpeq_epi8(y, dot))));
+    }
+#endif
+
+    for(;i<n;i++){
+        if(a1[i] == '0' && a2[i] == '0')
+            c00++;
+        else if(a1[i] == '1' && a2[i] == '1')
+            c11++;
+        if(a1[i] == '.' || a2[i] == '.')
+            cm++;
+    }
+    
+    *n00 = c00;
+    *n11 = c11;
+    *nmiss = cm;
+}
+
+void vcfAlleles(int *n, int *n00, int *n11, int *nmiss){
+    
+    int het=*n-*n00-*n11-*nmiss;
+    
+    *n00 = 2 * *n00 + het;
+    *n11 = 2 * *n11 + het;
+    *n = 2 * *n;
+    *nmiss = 2 * *nmiss;
+}
+
+static inline void storeDose(char *field, char *end, unsigned char *a1, unsigned char *a2, int n, int ploidy){
+    
+    int i, r=0, a=0;
+    char *p;
+    
+    for(i=0;i<ploidy;i++){
+        p = field + 2 * i;
+        if(p >= end || *p == '.' || *p == '\t' || (i > 0 && p[-1] != '/' && p[-1] != '|')){
+            a1[n] = a2[n] = 255;
+            return;
+        }
+        r += *p == '0';
+        a += *p == '1';
+    }
+    
+    a1[n] = r;
+    a2[n] = a;
+}
+
+static inline int scanDose(char *p, char *end, unsigned char *a1, unsigned char *a2, int ploidy){
+    
+    int n=0;
+    
+    storeDose(p, end, a1, a2, n++, ploidy);
+    
+    while((p = memchr(p, '\t', end - p)) != NULL)
+        storeDose(++p, end, a1, a2, n++, ploidy);
+    
+    return n;
+}
+
+int vcfDosage(char *start, char *end, int ploidy, unsigned char **a1, unsigned char **a2, int *max){
+    
+    if(end - start + 1 > *max){
+        *max = end - start + 1;
+        if((*a1 = realloc(*a1, *max)) == NULL || (*a2 = realloc(*a2, *max)) == NULL){
+            fprintf(stderr,merror);
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+    switch(ploidy){
+        case 2:
+            return scanDose(start, end, *a1, *a2, 2);
+        case 4:
+            return scanDose(start, end, *a1, *a2, 4);
+        case 6:
+            return scanDose(start, end, *a1, *a2, 6);
+        default:
+            return scanDose(start, end, *a1, *a2, ploidy);
+    }
+}
+
+int vcfPloidy(char *start, char *end, int ploidy){
+    
+    int i=0, k;
+    char *p=start, *q;
+    
+    while(p != NULL){
+        for(q=p,k=1;q < end && *q != '\t' && *q != ':';q++)
+            k += *q == '/' || *q == '|';
+        if(k != ploidy && q - p > (*p == '.'))
+            return i;
+        if((p = memchr(q, '\t', end - q)) != NULL)
+            p++;
+        i++;
+    }
+    
+    return -1;
+}
+
+void vcfDoseCount(unsigned char *a1, unsigned char *a2, int n, int ploidy, int *m, int *n00, int *n11, int *nmiss){
+    
+    int i, r=0, a=0, cm=0;
+    
+    for(i=0;i<n;i++){
+        if(a1[i] == 255)
+            cm++;
+        else{
+            r += a1[i];
+            a += a2[i];
+        }
+    }
+    
+    *m = ploidy * n;
+    *n00 = r;
+    *n11 = a;
+    *nmiss = ploidy * cm;
+}
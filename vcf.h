@@ -0,0 +1,36 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Field and genotype scanner for VCF data lines
+ 
+ The genotype columns are scanned with AVX2 or SSE2 when the compiler targets them (e.g. -mavx2 or -march=native), otherwise with a scalar loop. The line is never modified.
+ 
+ vcfGenotypes and vcfCount read the first two alleles of each call and count homozygous individuals. For allele counts, vcfAlleles turns the diploid counts into counts of alleles (heterozygotes give one of each), and vcfDosage reads calls of two or more alleles into the number of reference (0) and alternative (1) alleles of each sample (255 for a missing call), summed with vcfDoseCount; other alleles are called but count as neither. vcfAlleles is left for the genotype caches, which keep every heterozygous call as one code and so count a 0/2 or 1/2 call like 0/1. vcfPloidy returns the first sample whose call has another number of alleles than ploidy (a lone '.' is a missing call of any ploidy), or -1. Counts of alleles are returned in the same form as the genotype counts: n is the number of allele slots, n00 and n11 the reference and alternative alleles, and nmiss the slots of missing calls.
+ */
+
+#ifndef VCF_H
+#define VCF_H
+
+int vcfFields(char *line, char *end, char **field, int n);
+int vcfGenotypes(char *start, char *end, unsigned char **a1, unsigned char **a2, int *max);
+void vcfCount(unsigned char *a1, unsigned char *a2, int n, int *n00, int *n11, int *nmiss);
+void vcfAlleles(int *n, int *n00, int *n11, int *nmiss);
+int vcfDosage(char *start, char *end, int ploidy, unsigned char **a1, unsigned char **a2, int *max);
+int vcfPloidy(char *start, char *end, int ploidy);
+void vcfDoseCount(unsigned char *a1, unsigned char *a2, int n, int ploidy, int *m, int *n00, int *n11, int *nmiss);
+
+#endif
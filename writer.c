@@ -0,0 +1,167 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Buffered writer for the output tables
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <zlib.h>
+#include "writer.h"
+#define merror "\nERROR: System out of memory\n"
+#define chunk 1048576
+
+Writer_s *writerOpen(FILE *fp, int gz){
+    
+    Writer_s *w;
+    
+    if((w = calloc(1, sizeof(Writer_s))) == NULL || (w->buf = malloc(chunk)) == NULL){
+        fprintf(stderr,merror);
+        exit(EXIT_FAILURE);
+    }
+    
+    w->fp = fp;
+    w->size = chunk;
+    
+    if(gz && (w->gz = gzdopen(dup(fileno(fp)), "wb")) == NULL){
+        fprintf(stderr,"\nERROR: Cannot compress the output\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    return w;
+}
+
+void writerFlush(Writer_s *w){
+    
+    size_t n;
+    
+    if(w->n == 0)
+        return;
+    
+    if(w->gz != NULL)
+        n = gzwrite(w->gz, w->buf, w->n);
+    else
+        n = fwrite(w->buf, 1, w->n, w->fp);
+    
+    if(n != w->n){
+        fprintf(stderr,"\nERROR: Cannot write the output\n\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    w->n = 0;
+}
+
+void writerClose(Writer_s *w){
+    
+    writerFlush(w);
+    
+    if(w->gz != NULL)
+        gzclose(w->gz);
+    else
+        fflush(w->fp);
+    
+    free(w->buf);
+    free(w);
+}
+
+static inline char *reserve(Writer_s *w, size_t n){
+    
+    if(w->n + n > w->size)
+        writerFlush(w);
+    
+    return w->buf + w->n;
+}
+
+void writeStr(Writer_s *w, const char *s){
+    
+    size_t n=strlen(s);
+    
+    if(n > w->size){
+        writerFlush(w);
+        if(w->gz != NULL)
+            gzwrite(w->gz, s, n);
+        else
+            fwrite(s, 1, n, w->fp);
+        return;
+    }
+    
+    memcpy(reserve(w, n), s, n);
+    w->n += n;
+}
+
+void writeChar(Writer_s *w, char c){
+    
+    *reserve(w, 1) = c;
+    w->n++;
+}
+
+void writeInt(Writer_s *w, long long v){
+    
+    int i=0;
+    char *p, temp[24];
+    unsigned long long u = v < 0 ? -(unsigned long long)v : (unsigned long long)v;
+    
+    p = reserve(w, 24);
+    
+    do{
+        temp[i++] = '0' + u % 10;
+        u /= 10;
+    }while(u > 0);
+    
+    if(v < 0)
+        *p++ = '-';
+    while(i > 0)
+        *p++ = temp[--i];
+    
+    w->n = p - w->buf;
+}
+
+void writeFloat(Writer_s *w, double x){
+    
+    int i;
+    long long r;
+    double v, f;
+    char *p;
+    
+    v = fabs(x) * 1e6;
+    f = floor(v);
+    
+    if(!(fabs(x) < 1e6) || fabs(v - f - 0.5) < 1e-3){
+        i = snprintf(NULL, 0, "%f", x) + 1;
+        w->n += snprintf(reserve(w, i), i, "%f", x);
+        return;
+    }
+    
+    p = reserve(w, 32);
+    
+    r = (long long)f + (v - f > 0.5);
+    
+    if(signbit(x))
+        *p++ = '-';
+    w->n = p - w->buf;
+    writeInt(w, r / 1000000);
+    
+    p = w->buf + w->n;
+    *p++ = '.';
+    for(i=5,r%=1000000;i>=0;i--,r/=10)
+        p[i] = '0' + r % 10;
+    
+    w->n = p + 6 - w->buf;
+}
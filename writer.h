@@ -0,0 +1,44 @@
+/*
+ Version 2020.01.04
+ 
+ Copyright (C) 2020 Tuomas Hamala
+ 
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ For any other inquiries send an email to tuomas.hamala@gmail.com
+ 
+ Buffered writer for the output tables
+ 
+ Rows are formatted into a large buffer that is written out whole, optionally compressed with gzip. writeFloat gives the same text as printf's %f (it falls back to printf for values at or above a million and for rounding ties), writeInt the same as %lld. writerClose flushes the buffer but leaves the file open.
+ */
+
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <stdio.h>
+#include <zlib.h>
+
+typedef struct{
+    FILE *fp;
+    gzFile gz;
+    char *buf;
+    size_t n, size;
+}Writer_s;
+
+Writer_s *writerOpen(FILE *fp, int gz);
+void writerFlush(Writer_s *w);
+void writerClose(Writer_s *w);
+void writeStr(Writer_s *w, const char *s);
+void writeChar(Writer_s *w, char c);
+void writeInt(Writer_s *w, long long v);
+void writeFloat(Writer_s *w, double x);
+
+#endif